@@ -0,0 +1,350 @@
+#ifndef LAZYDB_BPLUSTREE_H
+#define LAZYDB_BPLUSTREE_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <utility>
+#include "db/BulkLoad.h"
+
+
+// B+ дерево: значения лежат только в листьях, листья связаны в двусвязный список.
+// Диапазонный поиск = один спуск до листа с from + последовательный проход по листьям до to.
+// Интерфейс такой же, как у BTree, поэтому годится для BTreeIndex.
+template<typename K, typename Ref>
+class BPlusTree {
+public:
+    // t = минимальная степень: в узле (кроме корня) от t-1 до 2t-1 ключей
+    BPlusTree(int minDegree = 16) {
+        if (minDegree < 2) {
+            t_ = 2;
+        } else {
+            t_ = minDegree;
+        }
+        root_ = std::make_unique<Node>(true);
+    }
+
+    void Clear() {
+        root_ = std::make_unique<Node>(true);
+    }
+
+    void Insert(const K& key, Ref ref) {
+        K upKey;
+        std::unique_ptr<Node> right = InsertInto(*root_, key, ref, upKey);
+        if (right) {
+            // корень разделился  дерево растёт вверх
+            auto newRoot = std::make_unique<Node>(false);
+            newRoot->keys.push_back(std::move(upKey));
+            newRoot->children.push_back(std::move(root_));
+            newRoot->children.push_back(std::move(right));
+            root_ = std::move(newRoot);
+        }
+    }
+
+    // убрать ref из списка значений key; если список опустел - удаляем и сам ключ
+    bool Remove(const K& key, Ref ref) {
+        Node* leaf = FindLeaf(key);
+        const size_t i = lbIndex(leaf->keys, key);
+        if (i == leaf->keys.size() || !(leaf->keys[i] == key)) return false;
+
+        std::vector<Ref>& vec = leaf->values[i];
+        auto it = std::find(vec.begin(), vec.end(), ref);
+        if (it == vec.end()) return false;
+        vec.erase(it);
+        if (vec.empty()) {
+            EraseKey(key);
+        }
+        return true;
+    }
+
+    // удалить ключ целиком (со всеми значениями)
+    bool EraseKey(const K& key) {
+        bool erased = DeleteFromNode(*root_, key);
+        if (!root_->leaf && root_->keys.empty()) {
+            std::unique_ptr<Node> child = std::move(root_->children[0]);
+            root_ = std::move(child);
+        }
+        return erased;
+    }
+
+    // Построение снизу вверх из уникальных ключей по возрастанию (см. SortForBulkLoad): листья
+    // заполняются на fillFactor и связываются в список, над ними так же упаковываются внутренние уровни.
+    // Прежнее содержимое дерева выбрасывается
+    void BulkLoad(std::vector<std::pair<K, std::vector<Ref>>>&& entries, double fillFactor = 1.0) {
+        Clear();
+        if (entries.empty()) return;
+
+        std::vector<std::unique_ptr<Node>> level;
+        std::vector<K> lows; // наименьший ключ поддерева каждого узла уровня - разделитель для родителя
+        const size_t n = entries.size();
+        const size_t leaves = PackedNodeCount(n, MaxKeys(), t_ - 1, fillFactor);
+        Node* prev = nullptr;
+        for (size_t i = 0, pos = 0; i < leaves; ++i) {
+            const size_t cnt = PackedNodeSize(n, leaves, i);
+            auto leaf = std::make_unique<Node>(true);
+            leaf->keys.reserve(cnt);
+            leaf->values.reserve(cnt);
+            for (size_t j = 0; j < cnt; ++j, ++pos) {
+                leaf->keys.push_back(std::move(entries[pos].first));
+                leaf->values.push_back(std::move(entries[pos].second));
+            }
+            leaf->prev = prev;
+            if (prev) prev->next = leaf.get();
+            prev = leaf.get();
+            lows.push_back(leaf->keys.front());
+            level.push_back(std::move(leaf));
+        }
+
+        while (level.size() > 1) {
+            const size_t m = level.size();
+            const size_t parents = PackedNodeCount(m, 2 * t_, t_, fillFactor);
+            std::vector<std::unique_ptr<Node>> upper;
+            std::vector<K> upperLows;
+            for (size_t i = 0, c = 0; i < parents; ++i) {
+                const size_t cnt = PackedNodeSize(m, parents, i);
+                auto node = std::make_unique<Node>(false);
+                upperLows.push_back(lows[c]);
+                for (size_t j = 0; j < cnt; ++j, ++c) {
+                    if (j > 0) node->keys.push_back(lows[c]);
+                    node->children.push_back(std::move(level[c]));
+                }
+                upper.push_back(std::move(node));
+            }
+            level = std::move(upper);
+            lows = std::move(upperLows);
+        }
+        root_ = std::move(level.front());
+    }
+
+    template<typename Q = K>
+    std::vector<Ref> FindEquals(const Q& key) const {
+        const std::vector<Ref>* vec = FindPostings(key);
+        if (!vec) return {};
+        return *vec; // копия
+    }
+
+    // список значений key без копирования (nullptr - ключа нет); живёт до следующего изменения дерева
+    template<typename Q = K>
+    const std::vector<Ref>* FindPostings(const Q& key) const {
+        const Node* leaf = FindLeaf(key);
+        const size_t i = lbIndex(leaf->keys, key);
+        if (i == leaf->keys.size() || !(leaf->keys[i] == key)) return nullptr;
+        return &leaf->values[i];
+    }
+
+    std::vector<Ref> FindRange(const K& from, const K& to) const {
+        std::vector<Ref> out;
+        const Node* leaf = FindLeaf(from);
+        size_t i = lbIndex(leaf->keys, from);
+        // дальше только вправо по списку листьев
+        while (leaf) {
+            for (; i < leaf->keys.size(); ++i) {
+                if (leaf->keys[i] > to) return out;
+                out.insert(out.end(), leaf->values[i].begin(), leaf->values[i].end());
+            }
+            leaf = leaf->next;
+            i = 0;
+        }
+        return out;
+    }
+
+private:
+    struct Node {
+        Node(bool leaf) : leaf(leaf) {}
+
+        bool leaf;
+        std::vector<K> keys; // в листе ключи записей, во внутреннем узле разделители
+        std::vector<std::vector<Ref>> values; // только в листе: values[i] соответствует keys[i]
+        std::vector<std::unique_ptr<Node>> children; // только во внутреннем: children.size() == keys.size()+1
+        Node* prev = nullptr; // соседние листья (владеет ими родитель, здесь просто ссылки)
+        Node* next = nullptr;
+    };
+    // Во внутреннем узле в children[i] лежат ключи из [keys[i-1], keys[i])
+
+    size_t t_;
+    std::unique_ptr<Node> root_;
+
+    size_t MaxKeys() const {return 2*t_-1;}
+
+    template<typename Q>
+    static size_t lbIndex(const std::vector<K>& keys, const Q& key) {
+        return std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    }
+
+    // номер ребёнка, в поддереве которого должен лежать key
+    template<typename Q>
+    static size_t ChildIndex(const std::vector<K>& keys, const Q& key) {
+        return std::upper_bound(keys.begin(), keys.end(), key) - keys.begin();
+    }
+
+    template<typename Q>
+    const Node* FindLeaf(const Q& key) const {
+        const Node* x = root_.get();
+        while (!x->leaf) {
+            x = x->children[ChildIndex(x->keys, key)].get();
+        }
+        return x;
+    }
+
+    Node* FindLeaf(const K& key) {
+        const BPlusTree* self = this;
+        return const_cast<Node*>(self->FindLeaf(key));
+    }
+
+    // Вставка снизу вверх: если узел переполнился, он делится и возвращает
+    // нового правого соседа, а разделитель для родителя кладёт в upKey
+    std::unique_ptr<Node> InsertInto(Node& x, const K& key, Ref ref, K& upKey) {
+        if (x.leaf) {
+            const size_t pos = lbIndex(x.keys, key);
+            if (pos < x.keys.size() && x.keys[pos] == key) {
+                x.values[pos].push_back(ref);
+                return nullptr;
+            }
+            x.keys.insert(x.keys.begin() + pos, key);
+            x.values.insert(x.values.begin() + pos, std::vector<Ref>{ref});
+            if (x.keys.size() <= MaxKeys()) return nullptr;
+            return SplitLeaf(x, upKey);
+        }
+
+        const size_t i = ChildIndex(x.keys, key);
+        K childUpKey;
+        std::unique_ptr<Node> right = InsertInto(*x.children[i], key, ref, childUpKey);
+        if (!right) return nullptr;
+
+        x.keys.insert(x.keys.begin() + i, std::move(childUpKey));
+        x.children.insert(x.children.begin() + (i + 1), std::move(right));
+        if (x.keys.size() <= MaxKeys()) return nullptr;
+        return SplitInternal(x, upKey);
+    }
+
+    // правая половина листа уходит в новый лист, первый его ключ копируется в родителя
+    std::unique_ptr<Node> SplitLeaf(Node& x, K& upKey) {
+        auto z = std::make_unique<Node>(true);
+        const size_t mid = x.keys.size() / 2;
+        for (size_t j = mid; j < x.keys.size(); ++j) {
+            z->keys.push_back(std::move(x.keys[j]));
+            z->values.push_back(std::move(x.values[j]));
+        }
+        x.keys.resize(mid);
+        x.values.resize(mid);
+
+        z->next = x.next;
+        z->prev = &x;
+        if (x.next) x.next->prev = z.get();
+        x.next = z.get();
+
+        upKey = z->keys.front();
+        return z;
+    }
+
+    // медиана внутреннего узла поднимается в родителя (в узлах её больше нет)
+    std::unique_ptr<Node> SplitInternal(Node& x, K& upKey) {
+        auto z = std::make_unique<Node>(false);
+        const size_t mid = x.keys.size() / 2;
+        upKey = std::move(x.keys[mid]);
+        for (size_t j = mid + 1; j < x.keys.size(); ++j) {
+            z->keys.push_back(std::move(x.keys[j]));
+        }
+        for (size_t j = mid + 1; j < x.children.size(); ++j) {
+            z->children.push_back(std::move(x.children[j]));
+        }
+        x.keys.resize(mid);
+        x.children.resize(mid + 1);
+        return z;
+    }
+
+    // Удаление снизу вверх: после удаления в ребёнке чиним его, если ключей стало меньше t-1
+    bool DeleteFromNode(Node& x, const K& key) {
+        if (x.leaf) {
+            const size_t i = lbIndex(x.keys, key);
+            if (i == x.keys.size() || !(x.keys[i] == key)) return false;
+            x.keys.erase(x.keys.begin() + i);
+            x.values.erase(x.values.begin() + i);
+            return true;
+        }
+
+        const size_t i = ChildIndex(x.keys, key);
+        if (!DeleteFromNode(*x.children[i], key)) return false;
+        if (x.children[i]->keys.size() < t_ - 1) {
+            FixUnderflow(x, i);
+        }
+        // разделители могли остаться равными удалённому ключу - это допустимо:
+        // все ключи правого поддерева по-прежнему >= разделителя
+        return true;
+    }
+
+    void FixUnderflow(Node& x, size_t i) {
+        if (i > 0 && x.children[i - 1]->keys.size() >= t_) {
+            BorrowFromLeft(x, i);
+        } else if (i < x.keys.size() && x.children[i + 1]->keys.size() >= t_) {
+            BorrowFromRight(x, i);
+        } else if (i < x.keys.size()) {
+            MergeChildren(x, i);
+        } else {
+            MergeChildren(x, i - 1);
+        }
+    }
+
+    void BorrowFromLeft(Node& x, size_t i) {
+        Node& child = *x.children[i];
+        Node& sib = *x.children[i - 1];
+        if (child.leaf) {
+            child.keys.insert(child.keys.begin(), std::move(sib.keys.back()));
+            child.values.insert(child.values.begin(), std::move(sib.values.back()));
+            sib.keys.pop_back();
+            sib.values.pop_back();
+            x.keys[i - 1] = child.keys.front();
+        } else {
+            child.keys.insert(child.keys.begin(), std::move(x.keys[i - 1]));
+            child.children.insert(child.children.begin(), std::move(sib.children.back()));
+            x.keys[i - 1] = std::move(sib.keys.back());
+            sib.keys.pop_back();
+            sib.children.pop_back();
+        }
+    }
+
+    void BorrowFromRight(Node& x, size_t i) {
+        Node& child = *x.children[i];
+        Node& sib = *x.children[i + 1];
+        if (child.leaf) {
+            child.keys.push_back(std::move(sib.keys.front()));
+            child.values.push_back(std::move(sib.values.front()));
+            sib.keys.erase(sib.keys.begin());
+            sib.values.erase(sib.values.begin());
+            x.keys[i] = sib.keys.front();
+        } else {
+            child.keys.push_back(std::move(x.keys[i]));
+            child.children.push_back(std::move(sib.children.front()));
+            x.keys[i] = std::move(sib.keys.front());
+            sib.keys.erase(sib.keys.begin());
+            sib.children.erase(sib.children.begin());
+        }
+    }
+
+    // children[i+1] вливается в children[i]
+    void MergeChildren(Node& x, size_t i) {
+        Node& left = *x.children[i];
+        Node& right = *x.children[i + 1];
+        if (left.leaf) {
+            for (size_t j = 0; j < right.keys.size(); ++j) {
+                left.keys.push_back(std::move(right.keys[j]));
+                left.values.push_back(std::move(right.values[j]));
+            }
+            left.next = right.next;
+            if (right.next) right.next->prev = &left;
+        } else {
+            // у внутренних узлов разделитель родителя опускается между ними
+            left.keys.push_back(std::move(x.keys[i]));
+            for (size_t j = 0; j < right.keys.size(); ++j) {
+                left.keys.push_back(std::move(right.keys[j]));
+            }
+            for (auto& c : right.children) {
+                left.children.push_back(std::move(c));
+            }
+        }
+        x.keys.erase(x.keys.begin() + i);
+        x.children.erase(x.children.begin() + (i + 1));
+    }
+};
+
+#endif // LAZYDB_BPLUSTREE_H
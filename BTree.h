@@ -4,6 +4,8 @@
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <utility>
+#include "db/BulkLoad.h"
 
 
 template<typename K, typename Ref> // k- тип ключа ref  ссылка на запись таблицы
@@ -32,13 +34,94 @@ public:
         }
         InsertNonFull(*root_, key, ref);
     }
-    // все записи ключ равен key
-    std::vector<Ref> FindEquals(const K& key) const {
+    // убрать ref из списка значений key; если список опустел - удаляем и сам ключ
+    bool Remove(const K& key, Ref ref) {
+        std::vector<Ref>* vec = FindPtr(*root_, key);
+        if (!vec) return false;
+        auto it = std::find(vec->begin(), vec->end(), ref);
+        if (it == vec->end()) return false;
+        vec->erase(it);
+        if (vec->empty()) {
+            EraseKey(key);
+        }
+        return true;
+    }
+
+    // удалить ключ целиком (со всеми значениями)
+    bool EraseKey(const K& key) {
+        bool erased = DeleteFromNode(*root_, key);
+        // корень мог опустеть после слияния двух его детей - дерево становится ниже
+        if (root_->keys.empty() && !root_->leaf) {
+            std::unique_ptr<Node> child = std::move(root_->children[0]);
+            root_ = std::move(child);
+        }
+        return erased;
+    }
+
+    // Построение снизу вверх из уникальных ключей по возрастанию (см. SortForBulkLoad).
+    // Листья заполняются на fillFactor, ключ между соседними листьями поднимается в родителя,
+    // уровни выше собираются так же. Прежнее содержимое дерева выбрасывается
+    void BulkLoad(std::vector<std::pair<K, std::vector<Ref>>>&& entries, double fillFactor = 1.0) {
+        Clear();
+        if (entries.empty()) return;
+
+        // n ключей = листья + (листьев-1) разделителей: делим n+1 на части "лист + разделитель после него"
+        std::vector<std::unique_ptr<Node>> level;
+        std::vector<std::pair<K, std::vector<Ref>>> seps; // seps[k] - между level[k] и level[k+1]
+        const size_t n = entries.size();
+        const size_t leaves = PackedNodeCount(n + 1, MaxKeys() + 1, t_, fillFactor);
+        for (size_t i = 0, pos = 0; i < leaves; ++i) {
+            const size_t cnt = PackedNodeSize(n + 1, leaves, i) - 1;
+            auto leaf = std::make_unique<Node>(true);
+            leaf->keys.reserve(cnt);
+            leaf->values.reserve(cnt);
+            for (size_t j = 0; j < cnt; ++j, ++pos) {
+                leaf->keys.push_back(std::move(entries[pos].first));
+                leaf->values.push_back(std::move(entries[pos].second));
+            }
+            level.push_back(std::move(leaf));
+            if (i + 1 < leaves) seps.push_back(std::move(entries[pos++]));
+        }
+
+        // разделители внутри группы детей становятся ключами родителя, между группами - уходят выше
+        while (level.size() > 1) {
+            const size_t m = level.size();
+            const size_t parents = PackedNodeCount(m, 2 * t_, t_, fillFactor);
+            std::vector<std::unique_ptr<Node>> upper;
+            std::vector<std::pair<K, std::vector<Ref>>> upperSeps;
+            for (size_t i = 0, c = 0; i < parents; ++i) {
+                const size_t cnt = PackedNodeSize(m, parents, i);
+                auto node = std::make_unique<Node>(false);
+                for (size_t j = 0; j < cnt; ++j, ++c) {
+                    if (j > 0) {
+                        node->keys.push_back(std::move(seps[c - 1].first));
+                        node->values.push_back(std::move(seps[c - 1].second));
+                    }
+                    node->children.push_back(std::move(level[c]));
+                }
+                upper.push_back(std::move(node));
+                if (i + 1 < parents) upperSeps.push_back(std::move(seps[c - 1]));
+            }
+            level = std::move(upper);
+            seps = std::move(upperSeps);
+        }
+        root_ = std::move(level.front());
+    }
+
+    // все записи ключ равен key (Q - K или сравнимый с ним тип, например string_view для string)
+    template<typename Q = K>
+    std::vector<Ref> FindEquals(const Q& key) const {
         const std::vector<Ref>* vec = FindPtr(*root_, key);
         if (!vec) return {};
         return *vec; // копия
     }
 
+    // список значений key без копирования (nullptr - ключа нет); живёт до следующего изменения дерева
+    template<typename Q = K>
+    const std::vector<Ref>* FindPostings(const Q& key) const {
+        return FindPtr(*root_, key);
+    }
+
     std::vector<Ref> FindRange(const K& from, const K& to) const {
         std::vector<Ref> out;
         RangeCollect(*root_, from, to, out);
@@ -63,7 +146,8 @@ private:
 
 
     //не привязана к конкретному объекту BTree
-    static int lbIndex(const std::vector<K>& keys, const K& key) {
+    template<typename Q>
+    static int lbIndex(const std::vector<K>& keys, const Q& key) {
         auto it = std::lower_bound(keys.begin(), keys.end(), key);
         int pos = it - keys.begin();
         return pos;
@@ -136,7 +220,114 @@ private:
         InsertNonFull(*x.children[i], key, ref); //при разыменовывании указателя мы получаем ссылку на ноду
     }
 
-    const std::vector<Ref>* FindPtr(const Node& x, const K& key) const {
+    // Удаление как в CLRS: спускаемся один раз сверху вниз и перед заходом в ребёнка
+    // следим, чтобы в нём было хотя бы t ключей (займ у соседа или слияние)
+    bool DeleteFromNode(Node& x, const K& key) {
+        size_t i = lbIndex(x.keys, key);
+
+        if (i < x.keys.size() && x.keys[i] == key) {
+            if (x.leaf) {
+                x.keys.erase(x.keys.begin() + i);
+                x.values.erase(x.values.begin() + i);
+                return true;
+            }
+            if (x.children[i]->keys.size() >= t_) {
+                // заменяем ключ предшественником и удаляем предшественника из левого поддерева
+                Node* cur = x.children[i].get();
+                while (!cur->leaf) cur = cur->children.back().get();
+                x.keys[i] = cur->keys.back();
+                x.values[i] = std::move(cur->values.back());
+                return DeleteFromNode(*x.children[i], x.keys[i]);
+            }
+            if (x.children[i + 1]->keys.size() >= t_) {
+                // то же с преемником из правого поддерева
+                Node* cur = x.children[i + 1].get();
+                while (!cur->leaf) cur = cur->children.front().get();
+                x.keys[i] = cur->keys.front();
+                x.values[i] = std::move(cur->values.front());
+                return DeleteFromNode(*x.children[i + 1], x.keys[i]);
+            }
+            // оба соседа минимальны  сливаем их вместе с ключом и удаляем уже в слитом узле
+            MergeChildren(x, i);
+            return DeleteFromNode(*x.children[i], key);
+        }
+
+        if (x.leaf) return false; // ключа нет
+
+        if (x.children[i]->keys.size() < t_) {
+            if (i > 0 && x.children[i - 1]->keys.size() >= t_) {
+                BorrowFromLeft(x, i);
+            } else if (i < x.keys.size() && x.children[i + 1]->keys.size() >= t_) {
+                BorrowFromRight(x, i);
+            } else if (i < x.keys.size()) {
+                MergeChildren(x, i);
+            } else {
+                MergeChildren(x, i - 1);
+                i = i - 1;
+            }
+        }
+        return DeleteFromNode(*x.children[i], key);
+    }
+
+    // children[i] + keys[i] + children[i+1] -> children[i]
+    void MergeChildren(Node& x, size_t i) {
+        Node& left = *x.children[i];
+        Node& right = *x.children[i + 1];
+
+        left.keys.push_back(std::move(x.keys[i]));
+        left.values.push_back(std::move(x.values[i]));
+        for (size_t j = 0; j < right.keys.size(); ++j) {
+            left.keys.push_back(std::move(right.keys[j]));
+            left.values.push_back(std::move(right.values[j]));
+        }
+        if (!left.leaf) {
+            for (auto& c : right.children) {
+                left.children.push_back(std::move(c));
+            }
+        }
+        x.keys.erase(x.keys.begin() + i);
+        x.values.erase(x.values.begin() + i);
+        x.children.erase(x.children.begin() + (i + 1)); // right удаляется вместе с unique_ptr
+    }
+
+    // ключ родителя опускается в children[i], последний ключ левого соседа поднимается в родителя
+    void BorrowFromLeft(Node& x, size_t i) {
+        Node& child = *x.children[i];
+        Node& sib = *x.children[i - 1];
+
+        child.keys.insert(child.keys.begin(), std::move(x.keys[i - 1]));
+        child.values.insert(child.values.begin(), std::move(x.values[i - 1]));
+        x.keys[i - 1] = std::move(sib.keys.back());
+        x.values[i - 1] = std::move(sib.values.back());
+        sib.keys.pop_back();
+        sib.values.pop_back();
+
+        if (!child.leaf) {
+            child.children.insert(child.children.begin(), std::move(sib.children.back()));
+            sib.children.pop_back();
+        }
+    }
+
+    // зеркально: первый ключ правого соседа поднимается в родителя
+    void BorrowFromRight(Node& x, size_t i) {
+        Node& child = *x.children[i];
+        Node& sib = *x.children[i + 1];
+
+        child.keys.push_back(std::move(x.keys[i]));
+        child.values.push_back(std::move(x.values[i]));
+        x.keys[i] = std::move(sib.keys.front());
+        x.values[i] = std::move(sib.values.front());
+        sib.keys.erase(sib.keys.begin());
+        sib.values.erase(sib.values.begin());
+
+        if (!child.leaf) {
+            child.children.push_back(std::move(sib.children.front()));
+            sib.children.erase(sib.children.begin());
+        }
+    }
+
+    template<typename Q>
+    const std::vector<Ref>* FindPtr(const Node& x, const Q& key) const {
         const size_t i = lbIndex(x.keys, key);
         if (i < x.keys.size() && x.keys[i] == key) {
             return &x.values[i];
@@ -145,6 +336,11 @@ private:
         return FindPtr(*x.children[i], key);
     }
 
+    std::vector<Ref>* FindPtr(Node& x, const K& key) {
+        const Node& cx = x;
+        return const_cast<std::vector<Ref>*>(FindPtr(cx, key));
+    }
+
     void RangeCollect(const Node& x, const K& from, const K& to, std::vector<Ref>& out) const {
         // идём по ключам в узле слева направо
         for (size_t i = 0; i < x.keys.size(); ++i) {
@@ -0,0 +1,119 @@
+#ifndef LAZYDB_BULKLOAD_H
+#define LAZYDB_BULKLOAD_H
+
+#include <vector>
+#include <utility>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+#include "core/FlatHashTable.h"
+
+
+// Общее для построения деревьев снизу вверх (BTree/BPlusTree/IntBPlusTree::BulkLoad)
+
+// На сколько узлов разложить n элементов: около maxPer*fillFactor в узле, но не меньше minPer
+// (кроме случая, когда узел один - это корень). Элементы потом делятся между узлами поровну,
+// так что в каждом от n/count до n/count+1 и ограничения min/max степени соблюдены
+inline size_t PackedNodeCount(size_t n, size_t maxPer, size_t minPer, double fillFactor) {
+    size_t target = (size_t)(maxPer * fillFactor);
+    target = std::min(maxPer, std::max(target, std::max<size_t>(minPer, 1)));
+    size_t count = (n + target - 1) / target;
+    if (count > 1 && n / count < minPer) {
+        count = std::max<size_t>(1, n / minPer);
+    }
+    return count;
+}
+
+// размер i-го из count узлов при равном делении n элементов
+inline size_t PackedNodeSize(size_t n, size_t count, size_t i) {
+    return n / count + (i < n % count ? 1 : 0);
+}
+
+// По выборке из пар: ключи часто повторяются (даты, годы, id родителя). Если уникальных ключей
+// порядка числа пар, повторы в случайной выборке почти не встречаются
+template<typename K, typename Ref>
+bool FewDistinctKeys(const std::vector<std::pair<K, Ref>>& pairs) {
+    static const size_t kSample = 1024;
+    if (pairs.size() < 4 * kSample) return false;
+    std::vector<K> sample;
+    sample.reserve(kSample);
+    for (size_t i = 0; i < kSample; ++i) {
+        sample.push_back(pairs[i * (pairs.size() / kSample)].first);
+    }
+    std::sort(sample.begin(), sample.end());
+    const size_t distinct = std::unique(sample.begin(), sample.end()) - sample.begin();
+    return distinct * 20 < kSample * 19; // больше 5% повторов
+}
+
+// Пары (ключ, ссылка) -> отсортированные уникальные ключи со списками ссылок.
+// Ссылки одного ключа идут по возрастанию - так же, как при вставке строк по порядку слотов.
+// threads > 1: куски сортируются параллельно, затем попарно сливаются
+template<typename K, typename Ref>
+std::vector<std::pair<K, std::vector<Ref>>> SortForBulkLoad(std::vector<std::pair<K, Ref>> pairs, size_t threads = 1) {
+    // при частых повторах дешевле сгруппировать пары хешем и сортировать только уникальные ключи
+    if (FewDistinctKeys(pairs)) {
+        FlatHashTable<K, size_t> pos(1024);
+        std::vector<std::pair<K, std::vector<Ref>>> entries;
+        for (auto& p : pairs) {
+            if (size_t* i = pos.GetPtr(p.first)) {
+                entries[*i].second.push_back(p.second);
+            } else {
+                pos.Set(p.first, entries.size());
+                entries.emplace_back(std::move(p.first), std::vector<Ref>{p.second});
+            }
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const auto& a, const auto& b) {return a.first < b.first;});
+        for (auto& e : entries) {
+            if (!std::is_sorted(e.second.begin(), e.second.end())) std::sort(e.second.begin(), e.second.end());
+        }
+        return entries;
+    }
+
+    static const size_t kMinPairsPerThread = 1 << 15;
+    threads = std::min(threads, std::max<size_t>(1, pairs.size() / kMinPairsPerThread));
+
+    if (threads <= 1) {
+        std::sort(pairs.begin(), pairs.end());
+    } else {
+        std::vector<size_t> bounds;
+        for (size_t i = 0; i <= threads; ++i) {
+            bounds.push_back(pairs.size() * i / threads);
+        }
+        std::vector<std::thread> pool;
+        for (size_t i = 0; i < threads; ++i) {
+            pool.emplace_back([&, i] {std::sort(pairs.begin() + bounds[i], pairs.begin() + bounds[i + 1]);});
+        }
+        for (auto& th : pool) th.join();
+
+        // слияние соседних кусков, за раунд число кусков уменьшается вдвое
+        while (bounds.size() > 2) {
+            std::vector<size_t> merged;
+            pool.clear();
+            for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+                merged.push_back(bounds[i]);
+                if (i + 2 < bounds.size()) {
+                    const size_t a = bounds[i], b = bounds[i + 1], c = bounds[i + 2];
+                    pool.emplace_back([&pairs, a, b, c] {
+                        std::inplace_merge(pairs.begin() + a, pairs.begin() + b, pairs.begin() + c);
+                    });
+                }
+            }
+            merged.push_back(bounds.back());
+            for (auto& th : pool) th.join();
+            bounds = std::move(merged);
+        }
+    }
+
+    std::vector<std::pair<K, std::vector<Ref>>> entries;
+    for (auto& p : pairs) {
+        if (entries.empty() || entries.back().first < p.first) {
+            entries.emplace_back(std::move(p.first), std::vector<Ref>{p.second});
+        } else {
+            entries.back().second.push_back(p.second);
+        }
+    }
+    return entries;
+}
+
+#endif // LAZYDB_BULKLOAD_H
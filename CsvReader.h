@@ -0,0 +1,218 @@
+#ifndef LAZYDB_CSVREADER_H
+#define LAZYDB_CSVREADER_H
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Разбор CSV прямо по байтам буфера (обычно отображённого файла, см. MappedFile.h):
+// строки и поля - string_view на исходные байты, числа - std::from_chars, без промежуточных строк.
+// Все поиски ';' и '\n' идут через CsvForEachMatch: блок байтов сравнивается с символами целиком,
+// movemask даёт битовую маску совпадений, позиции берутся из неё по одному ctz.
+// Загрузка таблицы идёт через ForEachCsvRow - один проход с общей маской ';' | '\n'
+
+inline size_t CsvCtz(uint32_t x) { // x != 0
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, x);
+    return idx;
+#else
+    return (size_t)__builtin_ctz(x);
+#endif
+}
+
+// fn(pos) для каждой позиции a или b в data по возрастанию; fn вернула false - поиск прекращается
+template<typename F>
+void CsvForEachMatch(std::string_view data, char a, char b, F&& fn) {
+    const char* p = data.data();
+    const size_t n = data.size();
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i av = _mm256_set1_epi8(a);
+    const __m256i bv = _mm256_set1_epi8(b);
+    for (; i + 32 <= n; i += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi8(block, av), _mm256_cmpeq_epi8(block, bv));
+        for (uint32_t mask = (uint32_t)_mm256_movemask_epi8(eq); mask; mask &= mask - 1) {
+            if (!fn(i + CsvCtz(mask))) return;
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128i av = _mm_set1_epi8(a);
+    const __m128i bv = _mm_set1_epi8(b);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(block, av), _mm_cmpeq_epi8(block, bv));
+        for (uint32_t mask = (uint32_t)_mm_movemask_epi8(eq); mask; mask &= mask - 1) {
+            if (!fn(i + CsvCtz(mask))) return;
+        }
+    }
+#endif
+    // хвост короче блока (или всё без SIMD) - побайтно
+    for (; i < n; ++i) {
+        if ((p[i] == a || p[i] == b) && !fn(i)) return;
+    }
+}
+
+template<typename F>
+void CsvForEachMatch(std::string_view data, char c, F&& fn) {
+    CsvForEachMatch(data, c, c, fn);
+}
+
+// позиция первого c в data начиная с from, либо data.size()
+inline size_t CsvFind(std::string_view data, size_t from, char c) {
+    size_t found = data.size();
+    if (from >= data.size()) return found;
+    CsvForEachMatch(data.substr(from), c, [&](size_t pos) {
+        found = from + pos;
+        return false;
+    });
+    return found;
+}
+
+// fn(line) для каждой строки data; '\r' в конце строки отбрасывается, пустые строки тоже передаются
+template<typename F>
+void ForEachCsvLine(std::string_view data, F&& fn) {
+    size_t pos = 0;
+    auto emit = [&](size_t end) {
+        std::string_view line = data.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        fn(line);
+        pos = end + 1;
+    };
+    CsvForEachMatch(data, '\n', [&](size_t end) {
+        emit(end);
+        return true;
+    });
+    if (pos < data.size()) emit(data.size()); // последняя строка без '\n'
+}
+
+// data, порезанная на parts кусков примерно равной длины по границам строк: каждый кусок, кроме
+// последнего, кончается '\n', так что ForEachCsvLine по кускам подряд даёт те же строки, что и по data.
+// Кусков может выйти меньше, если длинные строки съедят соседние границы
+inline std::vector<std::string_view> SplitCsvLines(std::string_view data, size_t parts) {
+    std::vector<std::string_view> chunks;
+    const size_t step = data.size() / std::max<size_t>(1, parts);
+    size_t from = 0;
+    for (size_t k = 1; k < parts && from < data.size(); ++k) {
+        const size_t cut = std::max(from, k * step);
+        const size_t end = CsvFind(data, cut, '\n');
+        if (end == data.size()) break;
+        chunks.push_back(data.substr(from, end + 1 - from));
+        from = end + 1;
+    }
+    if (from < data.size() || chunks.empty()) chunks.push_back(data.substr(from));
+    return chunks;
+}
+
+// Одна строка CSV, поделённая на поля. Поля - string_view на байты строки (строка должна жить дольше).
+// Как и прежний split через getline: "a;;b" - три поля, пустое последнее поле ("a;b;") не считается
+class CsvRow {
+public:
+    static constexpr size_t kMaxFields = 16; // лишние поля в конце строки отбрасываются, Overflow() == true
+
+    template<typename F>
+    friend void ForEachCsvRow(std::string_view data, char delim, F&& fn);
+
+    explicit CsvRow(std::string_view line, char delim = ';') : line_(line) {
+        size_t pos = 0;
+        CsvForEachMatch(line, delim, [&](size_t end) {
+            fields_[count_++] = line.substr(pos, end - pos);
+            pos = end + 1;
+            return count_ < kMaxFields;
+        });
+        if (pos < line.size()) {
+            if (count_ < kMaxFields) fields_[count_++] = line.substr(pos);
+            else overflow_ = true;
+        }
+    }
+
+    size_t Size() const { return count_; }
+    bool Overflow() const { return overflow_; } // в строке было больше kMaxFields полей - только для диагностики, строка при этом валидна
+    std::string_view Line() const { return line_; }
+    std::string_view operator[](size_t i) const { return fields_[i]; }
+    std::string Str(size_t i) const { return std::string(fields_[i]); }
+
+    // как std::stoi: пробелы и '+' в начале допустимы, хвост после числа игнорируется,
+    // но хотя бы одна цифра обязана быть
+    int Int(size_t i) const {
+        std::string_view f = TrimNumber(fields_[i]);
+        int value = 0;
+        const auto res = std::from_chars(f.data(), f.data() + f.size(), value);
+        if (res.ec != std::errc()) Fail(i);
+        return value;
+    }
+
+    double Double(size_t i) const {
+        std::string_view f = TrimNumber(fields_[i]);
+        double value = 0.0;
+        const auto res = std::from_chars(f.data(), f.data() + f.size(), value);
+        if (res.ec != std::errc()) Fail(i);
+        return value;
+    }
+
+private:
+    std::string_view line_;
+    std::string_view fields_[kMaxFields];
+    size_t count_ = 0;
+    bool overflow_ = false;
+
+    CsvRow() {}
+
+    void Add(const char* from, const char* to) {
+        if (count_ < kMaxFields) fields_[count_++] = std::string_view(from, size_t(to - from));
+        else overflow_ = true;
+    }
+
+    static std::string_view TrimNumber(std::string_view f) {
+        while (!f.empty() && (f.front() == ' ' || f.front() == '\t')) f.remove_prefix(1);
+        if (!f.empty() && f.front() == '+') f.remove_prefix(1);
+        return f;
+    }
+
+    [[noreturn]] void Fail(size_t i) const {
+        throw std::runtime_error("Bad number '" + std::string(fields_[i]) + "' in CSV line: " + std::string(line_));
+    }
+};
+
+// fn(row) для каждой строки data за один проход: ';' и '\n' ищутся одной маской, поля нарезаются сразу,
+// без отдельного поиска конца строки. Строки, поля и '\r' - те же, что у ForEachCsvLine + CsvRow
+// (пустая строка тоже передаётся: Line() пустая, Size() == 0). row живёт только до возврата из fn
+template<typename F>
+void ForEachCsvRow(std::string_view data, char delim, F&& fn) {
+    const char* p = data.data();
+    CsvRow row;
+    size_t lineStart = 0, fieldStart = 0;
+    auto endLine = [&](size_t end) {
+        if (end > lineStart && p[end - 1] == '\r') --end;
+        if (fieldStart < end) row.Add(p + fieldStart, p + end); // пустое последнее поле не считается
+        row.line_ = std::string_view(p + lineStart, end - lineStart);
+        fn(static_cast<const CsvRow&>(row));
+        row.count_ = 0;
+        row.overflow_ = false;
+    };
+    CsvForEachMatch(data, delim, '\n', [&](size_t pos) {
+        if (p[pos] == '\n') {
+            endLine(pos);
+            lineStart = pos + 1;
+        } else {
+            row.Add(p + fieldStart, p + pos);
+        }
+        fieldStart = pos + 1;
+        return true;
+    });
+    if (lineStart < data.size()) endLine(data.size()); // последняя строка без '\n'
+}
+
+#endif // LAZYDB_CSVREADER_H
@@ -2,12 +2,27 @@
 #define LAZYDB_DATABASE_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
+#include <algorithm>
+#include <deque>
+#include <chrono>
+#include <memory>
+#include <future>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <filesystem>
+#include <system_error>
+#include <thread>
 #include "db/Table.h"
 #include "db/DbErrors.h"
 #include "db/Index.h"
+#include "db/SemiJoin.h"
+#include "core/ThreadPool.h"
 #include "core/HashTable.h"
+#include "core/RoaringBitmap.h"
 #include "model/Address.h"
 #include "model/Department.h"
 #include "model/Employee.h"
@@ -17,51 +32,160 @@
 
 class Database {
 public:
+    // время одного этапа загрузки (wall clock)
+    struct LoadStage {
+        std::string name;
+        double ms;
+    };
+
+    struct LoadOptions {
+        size_t threads = 0;                               // потоков на всю загрузку, 0 - по числу ядер (делятся между таблицами)
+        std::vector<DbConstraintError>* errors = nullptr; // если задан - нарушения FK/UNIQUE собираются сюда, а не бросаются
+        std::vector<LoadStage>* stages = nullptr;         // если задан - сюда пишется время каждого этапа
+        bool lazyIndexes = false;                         // индексы не строить при загрузке: каждый - при первом поиске
+    };
+
     static Database LoadFromFiles(const std::string& addressesPath, const std::string& departmentsPath,const std::string& employeesPath,
         const std::string& suppliersPath,const std::string& productsPath,const std::string& purchasesPath)
     {
+        return LoadFromFiles(addressesPath, departmentsPath, employeesPath, suppliersPath, productsPath, purchasesPath,
+                             LoadOptions{});
+    }
+
+    // То же, но без исключения на первом нарушении FK/UNIQUE: все нарушения складываются в errors,
+    // база загружается целиком (ошибки разбора файлов по-прежнему бросаются; строки с повторным PK,
+    // как и раньше, молча пропускаются - в errors они не попадают)
+    static Database LoadFromFiles(const std::string& addressesPath, const std::string& departmentsPath,const std::string& employeesPath,
+        const std::string& suppliersPath,const std::string& productsPath,const std::string& purchasesPath,
+        std::vector<DbConstraintError>& errors, size_t threads = 0)
+    {
+        LoadOptions opts;
+        opts.threads = threads;
+        opts.errors = &errors;
+        return LoadFromFiles(addressesPath, departmentsPath, employeesPath, suppliersPath, productsPath, purchasesPath, opts);
+    }
+
+    // Таблицы читаются параллельно, проверка запускается, как только готовы её таблицы:
+    // addresses -> departments -> employees, suppliers -> products -> purchases.
+    // Задачи добавлены в порядке прежней последовательной загрузки, поэтому при нескольких
+    // ошибках бросается та же, что и раньше
+    static Database LoadFromFiles(const std::string& addressesPath, const std::string& departmentsPath,const std::string& employeesPath,
+        const std::string& suppliersPath,const std::string& productsPath,const std::string& purchasesPath,
+        const LoadOptions& opts)
+    {
+        const auto start = std::chrono::steady_clock::now();
         Database db;
-        db.addresses_ = Table<Address, int>::LoadFromFile(
-            addressesPath, "addresses",[](const Address& a) {return a.GetId();}
-        );
-        db.suppliers_ = Table<Supplier, int>::LoadFromFile(
-            suppliersPath, "suppliers", [](const Supplier& s) {return s.GetId();}
-        );
-        db.products_ = Table<Product, int>::LoadFromFile(
-            productsPath, "products",[](const Product& p) {return p.GetId();}
-        );
-        db.ValidateUniqueSupplierNames();
-        db.ValidateUniqueProductNames();
-        db.ValidateProductsDefaultSupplierFk();
-
-        db.departments_ = Table<Department, int>::LoadFromFile(
-            departmentsPath, "departments",[](const Department& d) {return d.GetId();}
-        );
-
-        db.ValidateUniqueDepartmentNames();
-        db.ValidateDepartmentsAddressFk();
-
-        db.employees_ = Table<Employee, int>::LoadFromFile(
-            employeesPath, "employees",[](const Employee& e) {return e.GetId();}
-        );
-
-        db.ValidateEmployeesDeptFk();
-
-        db.purchases_ = Table<Purchase, int>::LoadFromFile(
-            purchasesPath, "purchases",[](const Purchase& p) {return p.GetId();}
-        );
-
-        db.ValidatePurchasesFk();
-        db.BuildIndexes();
+        std::deque<std::vector<DbConstraintError>> found; // по списку на проверку, в порядке добавления
+        // таблицы грузятся одновременно: каждой - своя доля потоков, а не все ядра на каждую
+        const std::vector<size_t> th = SplitThreads(opts.threads, {addressesPath, departmentsPath, employeesPath,
+                                                                   suppliersPath, productsPath, purchasesPath});
+
+        TaskGraph graph;
+        auto check = [&](std::string name, std::vector<size_t> deps, auto validate) {
+            std::vector<DbConstraintError>& errors = found.emplace_back();
+            graph.Add(std::move(name), [&errors, &opts, validate] {
+                validate(errors);
+                if (!opts.errors) ThrowFirst(errors);
+            }, std::move(deps));
+        };
+
+        const size_t addresses = graph.Add("load addresses", [&] {
+            db.addresses_ = Table<Address, int>::LoadFromFile(
+                addressesPath, "addresses",[](const Address& a) {return a.GetId();}, th[0]
+            );
+        });
+        const size_t suppliers = graph.Add("load suppliers", [&] {
+            db.suppliers_ = Table<Supplier, int>::LoadFromFile(
+                suppliersPath, "suppliers", [](const Supplier& s) {return s.GetId();}, th[3]
+            );
+        });
+        const size_t products = graph.Add("load products", [&] {
+            db.products_ = Table<Product, int>::LoadFromFile(
+                productsPath, "products",[](const Product& p) {return p.GetId();}, th[4]
+            );
+        });
+        check("unique suppliers.name", {suppliers},
+              [&](std::vector<DbConstraintError>& e) {BuildUniqueIndex(db.suppliers_, db.suppliersByName_, e);});
+        check("unique products.name", {products},
+              [&](std::vector<DbConstraintError>& e) {BuildUniqueIndex(db.products_, db.productsByName_, e);});
+        check("fk products.default_supplier_id", {suppliers, products},
+              [&](std::vector<DbConstraintError>& e) {db.ValidateProductsDefaultSupplierFk(th[4], e);});
+
+        const size_t departments = graph.Add("load departments", [&] {
+            db.departments_ = Table<Department, int>::LoadFromFile(
+                departmentsPath, "departments",[](const Department& d) {return d.GetId();}, th[1]
+            );
+        });
+        check("unique departments.name", {departments},
+              [&](std::vector<DbConstraintError>& e) {BuildUniqueIndex(db.departments_, db.departmentsByName_, e);});
+        check("fk departments.address_id", {addresses, departments},
+              [&](std::vector<DbConstraintError>& e) {db.ValidateDepartmentsAddressFk(th[1], e);});
+
+        const size_t employees = graph.Add("load employees", [&] {
+            db.employees_ = Table<Employee, int>::LoadFromFile(
+                employeesPath, "employees",[](const Employee& e) {return e.GetId();}, th[2]
+            );
+        });
+        check("fk employees.dept_id", {departments, employees},
+              [&](std::vector<DbConstraintError>& e) {db.ValidateEmployeesDeptFk(th[2], e);});
+
+        const size_t purchases = graph.Add("load purchases", [&] {
+            db.purchases_ = Table<Purchase, int>::LoadFromFile(
+                purchasesPath, "purchases",[](const Purchase& p) {return p.GetId();}, th[5]
+            );
+        });
+        check("fk purchases", {departments, suppliers, products, purchases},
+              [&](std::vector<DbConstraintError>& e) {db.ValidatePurchasesFk(th[5], e);});
+
+        {
+            ThreadPool pool(opts.threads);
+            graph.Run(pool);
+        }
+
+        if (opts.errors) {
+            opts.errors->clear();
+            for (auto& f : found) {
+                opts.errors->insert(opts.errors->end(), f.begin(), f.end());
+            }
+        }
 
+        const auto indexStart = std::chrono::steady_clock::now();
+        if (!opts.lazyIndexes) {
+            db.BuildIndexes(opts.threads, false); // UNIQUE-индексы уже собраны проверками выше
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        if (opts.stages) {
+            opts.stages->clear();
+            graph.ForEachTiming([&](const std::string& name, double ms) {opts.stages->push_back({name, ms});});
+            if (!opts.lazyIndexes) {
+                opts.stages->push_back({"build indexes", std::chrono::duration<double, std::milli>(end - indexStart).count()});
+            }
+            opts.stages->push_back({"total", std::chrono::duration<double, std::milli>(end - start).count()});
+        }
         return db;
     }
+
 //     departments ссылается на addresses (address_id)
 // employees ссылается на departments (dept_id)
 // products ссылается на suppliers (default_supplier_id)
 // purchases ссылается на dept/supplier/product
 
 
+    // Все нарушения FK/UNIQUE за один проход вместо исключения на первом (пусто - данные согласованы).
+    // threads - на сколько потоков делить FK-проверки, 0 - по числу ядер
+    std::vector<DbConstraintError> CollectConstraintErrors(size_t threads = 0) const {
+        std::vector<DbConstraintError> errors;
+        ValidateUniqueSupplierNames(errors);
+        ValidateUniqueProductNames(errors);
+        ValidateProductsDefaultSupplierFk(threads, errors);
+        ValidateUniqueDepartmentNames(errors);
+        ValidateDepartmentsAddressFk(threads, errors);
+        ValidateEmployeesDeptFk(threads, errors);
+        ValidatePurchasesFk(threads, errors);
+        return errors;
+    }
+
     //геттеры таблиц
     const Table<Address, int>& Addresses() const {return addresses_;}
     const Table<Department, int>& Departments() const {return departments_;}
@@ -73,202 +197,253 @@ public:
 
 
     using Slot = size_t;
+    // ссылка деревьев-индексов: слот + id строки, диапазонный поиск отдаёт id без обращения к таблице
+    using IdRef = CoveringRef<>;
+    // ключи составных индексов purchases
+    using DeptDateKey = std::tuple<int, std::string>;
+    using ProductSupplierKey = std::tuple<int, int>;
     // Addresses
     //Найди через индекс  получи слоты →преврати в id  верни пользователю
-    std::vector<int> FindAddressIdsByCity(const std::string& city) const {
-        return SlotsToIds(addresses_, addressesByCity_.FindEquals(city));
+    // строковые ключи принимаются как string_view - поиск не создаёт временных строк
+    std::vector<int> FindAddressIdsByCity(std::string_view city) const {
+        return SlotsToIds(addresses_, Use(addresses_, addressesByCity_).FindEqualsView(city));
     }
     std::vector<int> FindAddressIdsByIdRange(int fromId, int toId) const {
-        return SlotsToIds(addresses_, addressesById_.FindRange(fromId, toId));
+        return SlotsToIds(addresses_, Use(addresses_, addressesById_).FindRange(fromId, toId));
     }
 
     // Departments
-    std::vector<int> FindDepartmentIdsByName(const std::string& name) const {
-        return SlotsToIds(departments_, departmentsByName_.FindEquals(name));
+    std::vector<int> FindDepartmentIdsByName(std::string_view name) const {
+        return SlotsToIds(departments_, Use(departments_, departmentsByName_).FindEqualsView(name));
     }
     std::vector<int> FindDepartmentIdsByAddressId(int addressId) const {
-        return SlotsToIds(departments_, departmentsByAddressId_.FindEquals(addressId));
+        return SlotsToIds(departments_, Use(departments_, departmentsByAddressId_).FindEqualsView(addressId));
     }
 
     // Employees
-    std::vector<int> FindEmployeeIdsByFullName(const std::string& fullName) const {
-        return SlotsToIds(employees_, employeesByFullName_.FindEquals(fullName));
+    std::vector<int> FindEmployeeIdsByFullName(std::string_view fullName) const {
+        return SlotsToIds(employees_, Use(employees_, employeesByFullName_).FindEqualsView(fullName));
     }
     std::vector<int> FindEmployeeIdsByBirthYearRange(int y1, int y2) const {
-        return SlotsToIds(employees_, employeesByBirthYear_.FindRange(y1, y2));
+        return SlotsToIds(employees_, Use(employees_, employeesByBirthYear_).FindRange(y1, y2));
     }
     std::vector<int> FindEmployeeIdsByDeptId(int deptId) const {
-        return SlotsToIds(employees_, employeesByDeptId_.FindEquals(deptId));
+        return BitmapToIds(employees_, Use(employees_, employeesByDeptId_).FindBitmap(deptId));
     }
 
     // Suppliers
-    std::vector<int> FindSupplierIdsByName(const std::string& name) const {
-        return SlotsToIds(suppliers_, suppliersByName_.FindEquals(name));
+    std::vector<int> FindSupplierIdsByName(std::string_view name) const {
+        return SlotsToIds(suppliers_, Use(suppliers_, suppliersByName_).FindEqualsView(name));
     }
-    std::vector<int> FindSupplierIdsByCity(const std::string& city) const {
-        return SlotsToIds(suppliers_, suppliersByCity_.FindEquals(city));
+    std::vector<int> FindSupplierIdsByCity(std::string_view city) const {
+        return SlotsToIds(suppliers_, Use(suppliers_, suppliersByCity_).FindEqualsView(city));
     }
 
     // Products
-    std::vector<int> FindProductIdsByName(const std::string& name) const {
-        return SlotsToIds(products_, productsByName_.FindEquals(name));
+    std::vector<int> FindProductIdsByName(std::string_view name) const {
+        return SlotsToIds(products_, Use(products_, productsByName_).FindEqualsView(name));
     }
     std::vector<int> FindProductIdsByDefaultSupplierId(int supplierId) const {
-        return SlotsToIds(products_, productsByDefaultSupplierId_.FindEquals(supplierId));
+        return SlotsToIds(products_, Use(products_, productsByDefaultSupplierId_).FindEqualsView(supplierId));
     }
 
     // Purchases
     std::vector<int> FindPurchaseIdsByDateRange(const std::string& from, const std::string& to) const {
-        return SlotsToIds(purchases_, purchasesByDate_.FindRange(from, to));
+        return SlotsToIds(purchases_, Use(purchases_, purchasesByDate_).FindRange(from, to));
     }
     std::vector<int> FindPurchaseIdsBySupplierId(int supplierId) const {
-        return SlotsToIds(purchases_, purchasesBySupplierId_.FindEquals(supplierId));
+        return BitmapToIds(purchases_, Use(purchases_, purchasesBySupplierId_).FindBitmap(supplierId));
     }
     std::vector<int> FindPurchaseIdsByProductId(int productId) const {
-        return SlotsToIds(purchases_, purchasesByProductId_.FindEquals(productId));
+        return BitmapToIds(purchases_, Use(purchases_, purchasesByProductId_).FindBitmap(productId));
     }
     std::vector<int> FindPurchaseIdsByDeptId(int deptId) const {
-        return SlotsToIds(purchases_, purchasesByDeptId_.FindEquals(deptId));
+        return BitmapToIds(purchases_, Use(purchases_, purchasesByDeptId_).FindBitmap(deptId));
+    }
+
+    // По составным индексам: одно обращение к индексу вместо скана по дате и фильтра вручную
+    std::vector<int> FindPurchaseIdsByDeptAndDateRange(int deptId, const std::string& from, const std::string& to) const {
+        return SlotsToIds(purchases_, Use(purchases_, purchasesByDeptDate_)
+                                          .FindRange(DeptDateKey(deptId, from), DeptDateKey(deptId, to)));
+    }
+    std::vector<int> FindPurchaseIdsByProductAndSupplier(int productId, int supplierId) const {
+        return SlotsToIds(purchases_, Use(purchases_, purchasesByProductSupplier_)
+                                          .FindEqualsView(ProductSupplierKey(productId, supplierId)));
+    }
+
+    // Несколько условий по FK сразу ("dept 5 AND supplier 17"): пересечение битмапов индексов.
+    // Незаданное условие (nullopt) не фильтрует; если не задано ни одного - все покупки
+    std::vector<int> FindPurchaseIdsByFks(std::optional<int> deptId, std::optional<int> supplierId,
+                                          std::optional<int> productId) const {
+        std::optional<RoaringBitmap> match;
+        if (deptId) IntersectWith(match, Use(purchases_, purchasesByDeptId_), *deptId);
+        if (supplierId) IntersectWith(match, Use(purchases_, purchasesBySupplierId_), *supplierId);
+        if (productId) IntersectWith(match, Use(purchases_, purchasesByProductId_), *productId);
+        if (!match) {
+            std::vector<int> ids;
+            ids.reserve(purchases_.GetRowCount());
+            purchases_.ForEachAlive([&](Slot, const Purchase& p) {ids.push_back(p.GetId());});
+            return ids;
+        }
+        return SlotsToIds(purchases_, *match);
     }
 
     // Построение всех индексов (вызывать после загрузки / после массовых правок)
-    void BuildIndexes() {
-        // Addresses
-        addressesByCity_.Build(addresses_.GetAliveSlots(), [&](Slot s) {return addresses_.GetRowBySlot(s).GetCity();});
-        addressesById_.Build(addresses_.GetAliveSlots(), [&](Slot s) {return addresses_.GetRowBySlot(s).GetId();});
+    // При LoadOptions::lazyIndexes индекс строится при первом поиске по нему; BuildIndexes - все сразу
+    // Insert*/Update*/Delete* ниже поддерживают индексы сами, полная перестройка после них не нужна
+    // Индексы независимы (строки только читаются), поэтому каждый строится отдельной задачей пула.
+    // Хеш-индексы больших таблиц (purchases) дополнительно строятся по кускам слотов и сливаются.
+    // threads = 0 - по числу ядер
+    void BuildIndexes(size_t threads = 0) {
+        BuildIndexes(threads, true);
+    }
 
-        // Departments
-        departmentsByName_.Build(departments_.GetAliveSlots(), [&](Slot s) {return departments_.GetRowBySlot(s).GetName();});
-        departmentsByAddressId_.Build(departments_.GetAliveSlots(), [&](Slot s) {return departments_.GetRowBySlot(s).GetAddressId();});
+    // Прогрев при ленивых индексах: достроить все ещё не построенные, по задаче на индекс.
+    // Поиски во время прогрева безопасны (каждый индекс строится один раз, кто первый - тот и строит)
+    void WarmUpIndexes(size_t threads = 0) const {
+        ThreadPool pool(threads);
+        TaskGraph graph;
+        ForEachTable(*this, [&](const auto& t) {
+            size_t n = 0;
+            VisitIndexes(*this, t, [&](const auto& lazy, auto) {
+                const std::string name = t.GetTableName() + " index " + std::to_string(n++);
+                if (lazy.IsBuilt()) return;
+                graph.Add(name, [this, &t, &lazy] {Use(t, lazy);});
+            });
+        });
+        graph.Run(pool);
+    }
 
-        // Employees
-        employeesByFullName_.Build(employees_.GetAliveSlots(), [&](Slot s) {return employees_.GetRowBySlot(s).GetFullName();});
-        employeesByBirthYear_.Build(employees_.GetAliveSlots(), [&](Slot s) {return employees_.GetRowBySlot(s).GetBirthYear();});
-        employeesByDeptId_.Build(employees_.GetAliveSlots(), [&](Slot s) {return employees_.GetRowBySlot(s).GetDeptId();});
+    // То же в фоне. База должна жить и не перемещаться, пока future не готов; правки строк -
+    // только после него (поиски можно сразу)
+    std::future<void> WarmUpIndexesAsync(size_t threads = 0) const {
+        return std::async(std::launch::async, [this, threads] {WarmUpIndexes(threads);});
+    }
 
-        // Suppliers
-        suppliersByName_.Build(suppliers_.GetAliveSlots(), [&](Slot s) {return suppliers_.GetRowBySlot(s).GetName(); });
-        suppliersByCity_.Build(suppliers_.GetAliveSlots(), [&](Slot s) {return suppliers_.GetRowBySlot(s).GetCity(); });
+    // Вставка: PK, UNIQUE и FK проверяются до изменения таблицы, индексы обновляются на месте
+    void InsertAddress(const Address& a) {
+        InsertRow(addresses_, a);
+    }
 
-        // Products
-        productsByName_.Build(products_.GetAliveSlots(), [&](Slot s) {return products_.GetRowBySlot(s).GetName(); });
-        productsByDefaultSupplierId_.Build(products_.GetAliveSlots(), [&](Slot s) {return products_.GetRowBySlot(s).GetDefaultSupplierId(); });
+    void InsertDepartment(const Department& d) {
+        Use(departments_, departmentsByName_).RequireFree(d.GetName(), nullptr);
+        RequireParent(addresses_, d.GetAddressId(), "departments", "address_id", "addresses", "id", -1);
+        InsertRow(departments_, d);
+    }
 
-        // Purchases
-        purchasesByDate_.Build(purchases_.GetAliveSlots(), [&](Slot s) {return purchases_.GetRowBySlot(s).GetDate(); });
-        purchasesBySupplierId_.Build(purchases_.GetAliveSlots(), [&](Slot s) {return purchases_.GetRowBySlot(s).GetSupplierId(); });
-        purchasesByProductId_.Build(purchases_.GetAliveSlots(), [&](Slot s) {return purchases_.GetRowBySlot(s).GetProductId(); });
-        purchasesByDeptId_.Build(purchases_.GetAliveSlots(), [&](Slot s) {return purchases_.GetRowBySlot(s).GetDeptId(); });
+    void InsertEmployee(const Employee& e) {
+        RequireParent(departments_, e.GetDeptId(), "employees", "dept_id", "departments", "id", -1);
+        InsertRow(employees_, e);
     }
 
+    void InsertSupplier(const Supplier& s) {
+        Use(suppliers_, suppliersByName_).RequireFree(s.GetName(), nullptr);
+        InsertRow(suppliers_, s);
+    }
 
-    void DeleteDepartment(int deptId) {
-        for (size_t i = 0; i < employees_.GetRowCount(); ++i) {
-            const auto& e = employees_.GetRow(i);
-            if (e.GetDeptId() == deptId) {
-                throw DbConstraintError::Restrict(
-                    "employees", "dept_id",
-                    std::to_string(deptId),
-                    "departments", "id",
-                    (int)i
-                );
-            }
+    void InsertProduct(const Product& p) {
+        Use(products_, productsByName_).RequireFree(p.GetName(), nullptr);
+        RequireParent(suppliers_, p.GetDefaultSupplierId(), "products", "default_supplier_id", "suppliers", "id", -1);
+        InsertRow(products_, p);
+    }
+
+    void InsertPurchase(const Purchase& p) {
+        RequirePurchaseParents(p, -1);
+        InsertRow(purchases_, p);
+    }
+
+    // Обновление строки по её id (id менять нельзя)
+    void UpdateAddress(const Address& a) {
+        if (!UpdateRow(addresses_, a)) {
+            throw std::runtime_error("Address not found: id=" + std::to_string(a.GetId()));
         }
-        for (size_t i = 0; i < purchases_.GetRowCount(); ++i) {
-            const auto& p = purchases_.GetRow(i);
-            if (p.GetDeptId() == deptId) {
-                throw DbConstraintError::Restrict(
-                    "purchases", "dept_id",
-                    std::to_string(deptId),
-                    "departments", "id",
-                    (int)i
-                );
-            }
+    }
+
+    void UpdateDepartment(const Department& d) {
+        Use(departments_, departmentsByName_).RequireFree(d.GetName(), departments_.FindSlot(d.GetId()));
+        RequireParent(addresses_, d.GetAddressId(), "departments", "address_id", "addresses", "id", -1);
+        if (!UpdateRow(departments_, d)) {
+            throw std::runtime_error("Department not found: id=" + std::to_string(d.GetId()));
         }
-        if (!departments_.DeleteById(deptId)) {
-            throw std::runtime_error("Department not found: id=" + std::to_string(deptId));
+    }
+
+    void UpdateEmployee(const Employee& e) {
+        RequireParent(departments_, e.GetDeptId(), "employees", "dept_id", "departments", "id", -1);
+        if (!UpdateRow(employees_, e)) {
+            throw std::runtime_error("Employee not found: id=" + std::to_string(e.GetId()));
         }
     }
 
-    void DeleteSupplier(int supplierId) {
-        for (size_t i = 0; i < products_.GetRowCount(); ++i) {
-            const auto& pr = products_.GetRow(i);
-            if (pr.GetDefaultSupplierId() == supplierId) {
-                throw DbConstraintError::Restrict(
-                    "products", "default_supplier_id",
-                    std::to_string(supplierId),
-                    "suppliers", "id",
-                    (int)i
-                );
-            }
+    void UpdateSupplier(const Supplier& s) {
+        Use(suppliers_, suppliersByName_).RequireFree(s.GetName(), suppliers_.FindSlot(s.GetId()));
+        if (!UpdateRow(suppliers_, s)) {
+            throw std::runtime_error("Supplier not found: id=" + std::to_string(s.GetId()));
         }
-        for (size_t i = 0; i < purchases_.GetRowCount(); ++i) {
-            const auto& p = purchases_.GetRow(i);
-            if (p.GetSupplierId() == supplierId) {
-                throw DbConstraintError::Restrict(
-                    "purchases", "supplier_id",
-                    std::to_string(supplierId),
-                    "suppliers", "id",
-                    (int)i
-                );
-            }
+    }
+
+    void UpdateProduct(const Product& p) {
+        Use(products_, productsByName_).RequireFree(p.GetName(), products_.FindSlot(p.GetId()));
+        RequireParent(suppliers_, p.GetDefaultSupplierId(), "products", "default_supplier_id", "suppliers", "id", -1);
+        if (!UpdateRow(products_, p)) {
+            throw std::runtime_error("Product not found: id=" + std::to_string(p.GetId()));
+        }
+    }
+
+    void UpdatePurchase(const Purchase& p) {
+        RequirePurchaseParents(p, -1);
+        if (!UpdateRow(purchases_, p)) {
+            throw std::runtime_error("Purchase not found: id=" + std::to_string(p.GetId()));
         }
-        if (!suppliers_.DeleteById(supplierId)) {
+    }
+
+
+    // RESTRICT проверяется по живым FK-индексам дочерних таблиц: O(1) на ссылку вместо скана
+    void DeleteDepartment(int deptId) {
+        ThrowIfReferenced(departments_, deptId);
+        if (!DeleteRow(departments_, deptId)) {
+            throw std::runtime_error("Department not found: id=" + std::to_string(deptId));
+        }
+    }
+
+    void DeleteSupplier(int supplierId) {
+        ThrowIfReferenced(suppliers_, supplierId);
+        if (!DeleteRow(suppliers_, supplierId)) {
             throw std::runtime_error("Supplier not found: id=" + std::to_string(supplierId));
         }
     }
 
     void DeleteProduct(int productId) {
-        for (size_t i = 0; i < purchases_.GetRowCount(); ++i) {
-            const auto& p = purchases_.GetRow(i);
-            if (p.GetProductId() == productId) {
-                throw DbConstraintError::Restrict(
-                    "purchases", "product_id",
-                    std::to_string(productId),
-                    "products", "id",
-                    (int)i
-                );
-            }
-        }
-        if (!products_.DeleteById(productId)) {
+        ThrowIfReferenced(products_, productId);
+        if (!DeleteRow(products_, productId)) {
             throw std::runtime_error("Product not found: id=" + std::to_string(productId));
         }
     }
 
     void DeleteAddress(int addressId) {
-        for (size_t i = 0; i < departments_.GetRowCount(); ++i) {
-            const auto& d = departments_.GetRow(i);
-            if (d.GetAddressId() == addressId) {
-                throw DbConstraintError::Restrict(
-                    "departments", "address_id",
-                    std::to_string(addressId),
-                    "addresses", "id",
-                    (int)i
-                );
-            }
-        }
-        if (!addresses_.DeleteById(addressId)) {
+        ThrowIfReferenced(addresses_, addressId);
+        if (!DeleteRow(addresses_, addressId)) {
             throw std::runtime_error("Address not found: id=" + std::to_string(addressId));
         }
     }
 
     void DeleteEmployee(int employeeId) {
-        if (!employees_.DeleteById(employeeId)) {
+        if (!DeleteRow(employees_, employeeId)) {
             throw std::runtime_error("Employee not found: id=" + std::to_string(employeeId));
         }
     }
 
     void DeletePurchase(int purchaseId) {
-        if (!purchases_.DeleteById(purchaseId)) {
+        if (!DeleteRow(purchases_, purchaseId)) {
             throw std::runtime_error("Purchase not found: id=" + std::to_string(purchaseId));
         }
     }
 
 private:
 
-    template<typename TRow>
+    template<typename TRow, typename Slots>
     // внутренние индексы строк (slot) в внешние идентификаторы (id)
-    static std::vector<int> SlotsToIds(const Table<TRow, int>& t, const std::vector<Slot>& slots) {
+    // Slots - вектор слотов или PostingView прямо из индекса (без промежуточной копии)
+    static std::vector<int> SlotsToIds(const Table<TRow, int>& t, const Slots& slots) {
         std::vector<int> ids;
         ids.reserve(slots.size()); //заранее выделяем память (чисто оптимизация)
         for (auto s : slots) {
@@ -277,31 +452,443 @@ private:
         return ids;
     }
 
+    // покрывающий индекс: id уже лежат в постингах, строки таблицы не читаются
+    template<typename TRow>
+    static std::vector<int> SlotsToIds(const Table<TRow, int>&, const std::vector<IdRef>& refs) {
+        std::vector<int> ids;
+        ids.reserve(refs.size());
+        for (const IdRef& r : refs) {
+            ids.push_back(r.id);
+        }
+        return ids;
+    }
+
+    template<typename TRow>
+    static std::vector<int> SlotsToIds(const Table<TRow, int>& t, const RoaringBitmap& slots) {
+        std::vector<int> ids;
+        ids.reserve(slots.Cardinality());
+        slots.ForEach([&](uint32_t s) {ids.push_back(t.GetRowBySlot(s).GetId());});
+        return ids;
+    }
+
+    // битмап ключа из BitmapIndex (nullptr - ключа нет): слоты идут прямо из битмапа,
+    // без промежуточного вектора, который собирает FindEqualsView
+    template<typename TRow>
+    static std::vector<int> BitmapToIds(const Table<TRow, int>& t, const RoaringBitmap* slots) {
+        return slots ? SlotsToIds(t, *slots) : std::vector<int>();
+    }
+
+    // match &= битмап ключа key (пустой match - ещё ни одного условия)
+    static void IntersectWith(std::optional<RoaringBitmap>& match, const BitmapIndex<int, Slot>& index, int key) {
+        const RoaringBitmap* bm = index.FindBitmap(key);
+        if (!bm) {
+            match = RoaringBitmap();
+        } else if (!match) {
+            match = *bm;
+        } else {
+            *match &= *bm;
+        }
+    }
+
+    // Список вторичных индексов каждой таблицы вместе с их ключами:
+    // fn(lazyIndex, keySelector). Одно место, по которому строятся и поддерживаются все индексы.
+    // Self - Database или const Database (тогда и индексы приходят const)
+    // Селекторы встраиваются в сборку; готовые строковые поля отдаются по const ссылке, без копии на строку
+    template<typename Self, typename Fn>
+    static void VisitIndexes(Self& db, const Table<Address, int>&, Fn&& fn) {
+        fn(db.addressesByCity_, [](const Address& a) -> const std::string& {return a.GetCity();});
+        fn(db.addressesById_, [](const Address& a) {return a.GetId();});
+    }
+
+    template<typename Self, typename Fn>
+    static void VisitIndexes(Self& db, const Table<Department, int>&, Fn&& fn) {
+        fn(db.departmentsByName_, [](const Department& d) -> const std::string& {return d.GetName();});
+        fn(db.departmentsByAddressId_, [](const Department& d) {return d.GetAddressId();});
+    }
+
+    template<typename Self, typename Fn>
+    static void VisitIndexes(Self& db, const Table<Employee, int>&, Fn&& fn) {
+        fn(db.employeesByFullName_, [](const Employee& e) {return e.GetFullName();});
+        fn(db.employeesByBirthYear_, [](const Employee& e) {return e.GetBirthYear();});
+        fn(db.employeesByDeptId_, [](const Employee& e) {return e.GetDeptId();});
+    }
+
+    template<typename Self, typename Fn>
+    static void VisitIndexes(Self& db, const Table<Supplier, int>&, Fn&& fn) {
+        fn(db.suppliersByName_, [](const Supplier& s) -> const std::string& {return s.GetName();});
+        fn(db.suppliersByCity_, [](const Supplier& s) -> const std::string& {return s.GetCity();});
+    }
+
+    template<typename Self, typename Fn>
+    static void VisitIndexes(Self& db, const Table<Product, int>&, Fn&& fn) {
+        fn(db.productsByName_, [](const Product& p) -> const std::string& {return p.GetName();});
+        fn(db.productsByDefaultSupplierId_, [](const Product& p) {return p.GetDefaultSupplierId(); });
+    }
+
+    template<typename Self, typename Fn>
+    static void VisitIndexes(Self& db, const Table<Purchase, int>&, Fn&& fn) {
+        fn(db.purchasesByDate_, [](const Purchase& p) -> const std::string& {return p.GetDate();});
+        fn(db.purchasesBySupplierId_, [](const Purchase& p) {return p.GetSupplierId(); });
+        fn(db.purchasesByProductId_, [](const Purchase& p) {return p.GetProductId(); });
+        fn(db.purchasesByDeptId_, [](const Purchase& p) {return p.GetDeptId(); });
+        fn(db.purchasesByDeptDate_, [](const Purchase& p) {return DeptDateKey(p.GetDeptId(), p.GetDate()); });
+        fn(db.purchasesByProductSupplier_, [](const Purchase& p) {return ProductSupplierKey(p.GetProductId(), p.GetSupplierId()); });
+    }
+
+    // ссылка на строку в том виде, который хранит индекс: слот или слот + id (покрывающий)
+    template<typename Ref, typename TRow>
+    static Ref MakeRef(Slot s, const TRow& row) {
+        if constexpr (std::is_same<Ref, IdRef>::value) {
+            return IdRef{s, row.GetId()};
+        } else {
+            return s;
+        }
+    }
+
+    template<typename Index>
+    using RefOf = typename std::decay_t<Index>::RefType;
+
+    template<typename Self, typename Fn>
+    static void ForEachTable(Self& db, Fn&& fn) {
+        fn(db.addresses_);
+        fn(db.departments_);
+        fn(db.employees_);
+        fn(db.suppliers_);
+        fn(db.products_);
+        fn(db.purchases_);
+    }
+
+    // индекс для чтения: если ещё не построен - строится сейчас по своей таблице и ключу из VisitIndexes
+    template<typename TRow, typename Index>
+    const Index& Use(const Table<TRow, int>& t, const LazyIndex<Index>& lazy) const {
+        return lazy.Get([&](Index& index) {
+            VisitIndexes(*this, t, [&](const auto& candidate, auto key) {
+                if constexpr (std::is_same<std::decay_t<decltype(candidate)>, LazyIndex<Index>>::value) {
+                    if (&candidate == &lazy) BuildIndex(t, index, key);
+                }
+            });
+        });
+    }
+
+    // индекс заново строится одним проходом по живым строкам, без промежуточного вектора слотов
+    template<typename TRow, typename Index, typename KeyFn>
+    static void BuildIndex(const Table<TRow, int>& t, Index& index, KeyFn key) {
+        index.Clear();
+        t.ForEachAlive([&](Slot s, const TRow& row) {index.Insert(key(row), MakeRef<RefOf<Index>>(s, row));});
+    }
+
+    // после сборки хеш-индекс запечатывается в CSR; первая же правка строки таблицы его распечатает
+    template<typename TRow, typename K, typename KeyFn>
+    static void BuildIndex(const Table<TRow, int>& t, HashIndex<K, Slot>& index, KeyFn key) {
+        index.Clear();
+        t.ForEachAlive([&](Slot s, const TRow& row) {index.Insert(key(row), s);});
+        index.Seal();
+    }
+
+    // дубли в таблице возможны только после загрузки с накоплением ошибок - остаётся первая строка
+    template<typename TRow, typename K, typename KeyFn>
+    static void BuildIndex(const Table<TRow, int>& t, UniqueHashIndex<K, Slot>& index, KeyFn key) {
+        index.Clear();
+        t.ForEachAlive([&](Slot s, const TRow& row) {index.TryInsert(key(row), s);});
+    }
+
+    // деревья строятся снизу вверх из отсортированных пар; запас в узлах под последующие вставки
+    static constexpr double kTreeIndexFillFactor = 0.9;
+
+    template<typename TRow, typename K, typename Ref, typename Tree, typename KeyFn>
+    static void BuildIndex(const Table<TRow, int>& t, BTreeIndex<K, Ref, Tree>& index, KeyFn key) {
+        std::vector<std::pair<K, Ref>> pairs;
+        pairs.reserve(t.GetRowCount());
+        t.ForEachAlive([&](Slot s, const TRow& row) {pairs.emplace_back(key(row), MakeRef<Ref>(s, row));});
+        index.BulkLoad(std::move(pairs), kTreeIndexFillFactor);
+    }
+
+    // withUnique = false - UNIQUE-индексы не трогать (при загрузке их собирает проверка UNIQUE)
+    void BuildIndexes(size_t threads, bool withUnique) {
+        ThreadPool pool(threads);
+        TaskGraph graph;
+        ForEachTable(*this, [&](const auto& t) {AddIndexBuildTasks(graph, t, pool.Size(), withUnique);});
+        graph.Run(pool);
+        ForEachTable(*this, [&](const auto& t) {
+            VisitIndexes(*this, t, [](auto& lazy, auto) {lazy.MarkBuilt();});
+        });
+    }
+
+    template<typename Index>
+    struct IsUniqueIndex : std::false_type {};
+    template<typename K, typename Ref>
+    struct IsUniqueIndex<UniqueHashIndex<K, Ref>> : std::true_type {};
+
+    template<typename TRow>
+    void AddIndexBuildTasks(TaskGraph& graph, const Table<TRow, int>& t, size_t parts, bool withUnique) {
+        size_t n = 0;
+        VisitIndexes(*this, t, [&](auto& lazy, auto key) {
+            const std::string name = t.GetTableName() + " index " + std::to_string(n++);
+            if (!withUnique && IsUniqueIndex<typename std::decay_t<decltype(lazy)>::IndexType>::value) return;
+            AddIndexBuildTask(graph, name, t, lazy.Raw(), key, parts);
+        });
+    }
+
+    template<typename TRow, typename Index, typename KeyFn>
+    static void AddIndexBuildTask(TaskGraph& graph, std::string name, const Table<TRow, int>& t,
+                                  Index& index, KeyFn key, size_t) {
+        graph.Add(std::move(name), [&t, &index, key] {BuildIndex(t, index, key);});
+    }
+
+    // Хеш-индекс по кускам: каждый кусок слотов - свой частичный индекс в своей задаче,
+    // потом частичные индексы сливаются по порядку кусков (постинги остаются по возрастанию слота)
+    template<typename TRow, typename K, typename KeyFn>
+    static void AddIndexBuildTask(TaskGraph& graph, std::string name, const Table<TRow, int>& t,
+                                  HashIndex<K, Slot>& index, KeyFn key, size_t parts) {
+        static const size_t kMinRowsPerPart = 1 << 15; // на меньших кусках слияние дороже выигрыша
+        parts = std::min(parts, t.GetRowCount() / kMinRowsPerPart);
+        if (parts <= 1) {
+            graph.Add(std::move(name), [&t, &index, key] {BuildIndex(t, index, key);});
+            return;
+        }
+
+        auto partial = std::make_shared<std::vector<HashIndex<K, Slot>>>(parts);
+        const size_t chunk = (t.GetSlotCount() + parts - 1) / parts;
+        std::vector<size_t> partTasks;
+        for (size_t k = 0; k < parts; ++k) {
+            partTasks.push_back(graph.Add(name + " part " + std::to_string(k), [&t, partial, key, k, chunk] {
+                HashIndex<K, Slot>& part = (*partial)[k];
+                t.ForEachAliveInSlots(k * chunk, (k + 1) * chunk, [&](Slot s, const TRow& row) {part.Insert(key(row), s);});
+            }));
+        }
+        graph.Add(name + " merge", [&index, partial] {
+            index.Clear();
+            for (HashIndex<K, Slot>& part : *partial) {
+                index.MergeFrom(std::move(part));
+            }
+            index.Seal();
+        }, std::move(partTasks));
+    }
+
+    template<typename TRow>
+    void IndexRow(const Table<TRow, int>& t, Slot s, const TRow& row) {
+        VisitIndexes(*this, t, [&](auto& lazy, auto key) {
+            if (auto* index = lazy.IfBuilt()) index->Insert(key(row), MakeRef<RefOf<decltype(*index)>>(s, row));
+        });
+    }
+
+    template<typename TRow>
+    void UnindexRow(const Table<TRow, int>& t, Slot s, const TRow& row) {
+        VisitIndexes(*this, t, [&](auto& lazy, auto key) {
+            if (auto* index = lazy.IfBuilt()) index->Remove(key(row), MakeRef<RefOf<decltype(*index)>>(s, row));
+        });
+    }
+
+    template<typename TRow>
+    void InsertRow(Table<TRow, int>& t, const TRow& row) {
+        if (t.ContainsId(row.GetId())) {
+            throw DbConstraintError::PrimaryKeyDuplicate(t.GetTableName(), "id", std::to_string(row.GetId()), -1);
+        }
+        t.Insert(row);
+        IndexRow(t, *t.FindSlot(row.GetId()), row);
+    }
+
+    template<typename TRow>
+    bool UpdateRow(Table<TRow, int>& t, const TRow& row) {
+        const Slot* slotPtr = t.FindSlot(row.GetId());
+        if (!slotPtr) return false;
+        const Slot s = *slotPtr;
+        UnindexRow(t, s, t.GetRowBySlot(s)); // старые ключи убираем до перезаписи строки
+        t.UpdateById(row.GetId(), row);
+        IndexRow(t, s, row);
+        return true;
+    }
+
+    template<typename TRow>
+    bool DeleteRow(Table<TRow, int>& t, int id) {
+        const Slot* slotPtr = t.FindSlot(id);
+        if (!slotPtr) return false;
+        const Slot s = *slotPtr;
+        UnindexRow(t, s, t.GetRowBySlot(s));
+        return t.DeleteById(id);
+    }
+
+    template<typename TParent>
+    static void RequireParent(const Table<TParent, int>& parent, int ref,
+                              const char* table, const char* field,
+                              const char* refTable, const char* refField, int rowIndex) {
+        if (!parent.ContainsId(ref)) {
+            throw DbConstraintError::ForeignKey(table, field, std::to_string(ref), refTable, refField, rowIndex);
+        }
+    }
+
+    void RequirePurchaseParents(const Purchase& pur, int rowIndex) const {
+        RequireParent(departments_, pur.GetDeptId(), "purchases", "dept_id", "departments", "id", rowIndex);
+        RequireParent(suppliers_, pur.GetSupplierId(), "purchases", "supplier_id", "suppliers", "id", rowIndex);
+        RequireParent(products_, pur.GetProductId(), "purchases", "product_id", "products", "id", rowIndex);
+    }
+
+    // Кто ссылается на таблицу: fn(childTable, fkIndex, childTableName, fkField).
+    // FK-индексы поддерживаются при каждой вставке/обновлении/удалении, поэтому ими можно
+    // проверять RESTRICT без прохода по дочерней таблице
+    template<typename Fn>
+    void VisitReferencesTo(const Table<Address, int>&, Fn&& fn) const {
+        fn(departments_, departmentsByAddressId_, "departments", "address_id");
+    }
+
+    template<typename Fn>
+    void VisitReferencesTo(const Table<Department, int>&, Fn&& fn) const {
+        fn(employees_, employeesByDeptId_, "employees", "dept_id");
+        fn(purchases_, purchasesByDeptId_, "purchases", "dept_id");
+    }
+
+    template<typename Fn>
+    void VisitReferencesTo(const Table<Supplier, int>&, Fn&& fn) const {
+        fn(products_, productsByDefaultSupplierId_, "products", "default_supplier_id");
+        fn(purchases_, purchasesBySupplierId_, "purchases", "supplier_id");
+    }
+
+    template<typename Fn>
+    void VisitReferencesTo(const Table<Product, int>&, Fn&& fn) const {
+        fn(purchases_, purchasesByProductId_, "purchases", "product_id");
+    }
+
+    // RESTRICT: если хоть одна живая строка ссылается на id - ошибка с номером этой строки
+    template<typename TParent>
+    void ThrowIfReferenced(const Table<TParent, int>& parent, int id) const {
+        VisitReferencesTo(parent, [&](const auto& child, const auto& fkIndex, const char* table, const char* field) {
+            if (std::optional<Slot> first = FirstReferencing(Use(child, fkIndex), id)) {
+                throw DbConstraintError::Restrict(table, field, std::to_string(id), parent.GetTableName(), "id",
+                                                  (int)child.AliveIndexOfSlot(*first));
+            }
+        });
+    }
+
+    // в ошибке - первая по порядку строка, как при скане (постинги после Update не отсортированы)
+    template<typename Index>
+    static std::optional<Slot> FirstReferencing(const Index& fkIndex, int id) {
+        PostingView<Slot> refs = fkIndex.FindEqualsView(id);
+        if (refs.empty()) return std::nullopt;
+        return *std::min_element(refs.begin(), refs.end());
+    }
+
+    // у битмапа наименьший слот берётся сразу, без расшифровки списка
+    static std::optional<Slot> FirstReferencing(const BitmapIndex<int, Slot>& fkIndex, int id) {
+        const RoaringBitmap* bm = fkIndex.FindBitmap(id);
+        if (!bm) return std::nullopt;
+        return bm->Min();
+    }
+
+    // FK пакетно: столбец ссылок child целиком проверяется semi-join'ом с множеством id parent,
+    // каждое нарушение дописывается в errors (rowIndex - номер живой строки child)
+    template<typename TRow, typename TParent, typename FkFn>
+    static void ValidateFk(const Table<TRow, int>& child, const Table<TParent, int>& parent, FkFn fk,
+                           const char* table, const char* field,
+                           const char* refTable, const char* refField,
+                           size_t threads, std::vector<DbConstraintError>& errors) {
+        std::vector<int> keys;
+        keys.reserve(child.GetRowCount());
+        child.ForEachAlive([&](Slot, const TRow& row) {keys.push_back(fk(row));});
+
+        for (size_t i : SemiJoinMisses(keys, ParentIds(parent), threads)) {
+            errors.push_back(DbConstraintError::ForeignKey(table, field, std::to_string(keys[i]),
+                                                           refTable, refField, (int)i));
+        }
+    }
+
+    template<typename TParent>
+    static IdSet ParentIds(const Table<TParent, int>& parent) {
+        std::vector<int> ids;
+        ids.reserve(parent.GetRowCount());
+        parent.ForEachAlive([&](Slot, const TParent& row) {ids.push_back(row.GetId());});
+        return IdSet(std::move(ids));
+    }
+
+    // UNIQUE при загрузке: индекс name собирается сразу с проверкой, первая строка с именем
+    // остаётся в индексе, на каждый повтор - ошибка с номером живой строки
+    template<typename TRow>
+    static void BuildUniqueIndex(const Table<TRow, int>& t, LazyIndex<UniqueHashIndex<std::string, Slot>>& lazy,
+                                 std::vector<DbConstraintError>& errors) {
+        UniqueHashIndex<std::string, Slot>& byName = lazy.Raw();
+        byName.Clear();
+        int i = 0;
+        t.ForEachAlive([&](Slot s, const TRow& row) {
+            if (!byName.TryInsert(row.GetName(), s)) {
+                errors.push_back(byName.DuplicateError(row.GetName(), i));
+            }
+            ++i;
+        });
+        lazy.MarkBuilt();
+    }
+
+    // UNIQUE по уже собранному индексу: повтор - строка, которой нет в индексе под своим именем
+    template<typename TRow>
+    static void ValidateUniqueNames(const Table<TRow, int>& t, const UniqueHashIndex<std::string, Slot>& byName,
+                                    std::vector<DbConstraintError>& errors) {
+        int i = 0;
+        t.ForEachAlive([&](Slot s, const TRow& row) {
+            const Slot* owner = byName.Find(row.GetName());
+            if (!owner || *owner != s) {
+                errors.push_back(byName.DuplicateError(row.GetName(), i));
+            }
+            ++i;
+        });
+    }
+
+    // threads (0 - по числу ядер) на задачи, идущие одновременно: доля каждой пропорциональна размеру
+    // её файла, не меньше одного потока. Сумма долей - примерно threads, без оверсабскрипшена
+    static std::vector<size_t> SplitThreads(size_t threads, const std::vector<std::string>& paths) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::vector<uintmax_t> sizes;
+        uintmax_t total = 0;
+        for (const std::string& path : paths) {
+            std::error_code ec;
+            const uintmax_t size = std::filesystem::file_size(path, ec);
+            sizes.push_back(ec ? 0 : size); // нет файла - ошибку даст сама загрузка
+            total += sizes.back();
+        }
+        std::vector<size_t> shares;
+        for (uintmax_t size : sizes) {
+            shares.push_back(total == 0 ? 1 : std::max<size_t>(1, size_t(threads * size / total)));
+        }
+        return shares;
+    }
+
+    // режим "до первой ошибки": бросаем самую раннюю по номеру строки
+    // (при равенстве - в порядке проверок, как при построчной проверке)
+    static void ThrowFirst(const std::vector<DbConstraintError>& errors) {
+        if (errors.empty()) return;
+        auto first = std::min_element(errors.begin(), errors.end(),
+            [](const DbConstraintError& a, const DbConstraintError& b) {return a.GetRowIndex() < b.GetRowIndex();});
+        throw *first;
+    }
+
     // Addresses
-    HashIndex<std::string, Slot> addressesByCity_{512};
-    BTreeIndex<int, Slot> addressesById_{16};
+    LazyIndex<HashIndex<std::string, Slot>> addressesByCity_{512};
+    LazyIndex<BTreeIndex<int, IdRef, IntBPlusTree<IdRef, 16>>> addressesById_{16};
     // Departments
-    HashIndex<std::string, Slot> departmentsByName_{256};
-    HashIndex<int, Slot> departmentsByAddressId_{256};
+    LazyIndex<UniqueHashIndex<std::string, Slot>> departmentsByName_{"departments", "name", 256};
+    LazyIndex<HashIndex<int, Slot>> departmentsByAddressId_{256};
 
     // Employees
-    HashIndex<std::string, Slot> employeesByFullName_{1024};
-    BTreeIndex<int, Slot> employeesByBirthYear_{16};
-    HashIndex<int, Slot> employeesByDeptId_{1024};
+    LazyIndex<HashIndex<std::string, Slot>> employeesByFullName_{1024};
+    LazyIndex<BTreeIndex<int, IdRef, IntBPlusTree<IdRef, 16>>> employeesByBirthYear_{16};
+    LazyIndex<BitmapIndex<int, Slot>> employeesByDeptId_{64};
 
     // Suppliers
-    HashIndex<std::string, Slot> suppliersByName_{1024};
-    HashIndex<std::string, Slot> suppliersByCity_{512};
+    LazyIndex<UniqueHashIndex<std::string, Slot>> suppliersByName_{"suppliers", "name", 1024};
+    LazyIndex<HashIndex<std::string, Slot>> suppliersByCity_{512};
 
     // Products
-    HashIndex<std::string, Slot> productsByName_{1024};
-    HashIndex<int, Slot> productsByDefaultSupplierId_{1024};
+    LazyIndex<UniqueHashIndex<std::string, Slot>> productsByName_{"products", "name", 1024};
+    LazyIndex<HashIndex<int, Slot>> productsByDefaultSupplierId_{1024};
 
     // Purchases
-    BTreeIndex<std::string, Slot> purchasesByDate_{16}; // YYYY-MM-DD => range works
-    HashIndex<int, Slot> purchasesBySupplierId_{2048};
-    HashIndex<int, Slot> purchasesByProductId_{2048};
-    HashIndex<int, Slot> purchasesByDeptId_{2048};
+    LazyIndex<BTreeIndex<std::string, IdRef, BPlusTree<std::string, IdRef>>> purchasesByDate_{16}; // YYYY-MM-DD => range works
+    // FK с малым числом значений и длинными списками - битмапы, их можно пересекать между собой
+    LazyIndex<BitmapIndex<int, Slot>> purchasesBySupplierId_{64};
+    LazyIndex<BitmapIndex<int, Slot>> purchasesByProductId_{128};
+    LazyIndex<BitmapIndex<int, Slot>> purchasesByDeptId_{64};
+    // составные: (dept_id, date) для диапазона дат внутри отдела, (product_id, supplier_id) - равенство
+    LazyIndex<BTreeIndex<DeptDateKey, IdRef, BPlusTree<DeptDateKey, IdRef>>> purchasesByDeptDate_{16};
+    LazyIndex<HashIndex<ProductSupplierKey, Slot>> purchasesByProductSupplier_{2048};
 
     Table<Address, int> addresses_;
     Table<Department, int> departments_;
@@ -311,116 +898,41 @@ private:
     Table<Purchase, int> purchases_;
 
 
-    void ValidateUniqueDepartmentNames() const { //в таблице departments поле name должно быть уникальным
-        HashTable<std::string, int> seen(128);
-        for (size_t i = 0; i < departments_.GetRowCount(); ++i) {
-            const auto& d = departments_.GetRow(i);
-            const std::string& name = d.GetName();
-            if (seen.ContainsKey(name)) {
-                throw DbConstraintError::Unique("departments", "name", name, (int)i);
-            }
-            seen.Add(name, d.GetId());
-        }
+    // Validate*(errors) - дописать все нарушения
+    void ValidateUniqueDepartmentNames(std::vector<DbConstraintError>& errors) const { //в таблице departments поле name должно быть уникальным
+        ValidateUniqueNames(departments_, Use(departments_, departmentsByName_), errors);
     }
 
-    void ValidateUniqueSupplierNames() const {
-        HashTable<std::string, int> seen(256);
-        for (size_t i = 0; i < suppliers_.GetRowCount(); ++i) {
-            const auto& s = suppliers_.GetRow(i);
-            const std::string& name = s.GetName();
-            if (seen.ContainsKey(name)) {
-                throw DbConstraintError::Unique("suppliers", "name", name, (int)i);
-            }
-            seen.Add(name, s.GetId());
-        }
+    void ValidateUniqueSupplierNames(std::vector<DbConstraintError>& errors) const {
+        ValidateUniqueNames(suppliers_, Use(suppliers_, suppliersByName_), errors);
     }
 
-    void ValidateUniqueProductNames() const {
-        HashTable<std::string, int> seen(512);
-        for (size_t i = 0; i < products_.GetRowCount(); ++i) {
-            const auto& p = products_.GetRow(i);
-            const std::string& name = p.GetName();
-            if (seen.ContainsKey(name)) {
-                throw DbConstraintError::Unique("products", "name", name, (int)i);
-            }
-            seen.Add(name, p.GetId());
-        }
+    void ValidateUniqueProductNames(std::vector<DbConstraintError>& errors) const {
+        ValidateUniqueNames(products_, Use(products_, productsByName_), errors);
     }
 
-    void ValidateDepartmentsAddressFk() const {
-        for (size_t i = 0; i < departments_.GetRowCount(); ++i) {
-            const auto& d = departments_.GetRow(i);
-            int addrId = d.GetAddressId();
-            if (!addresses_.ContainsId(addrId)) {
-                throw DbConstraintError::ForeignKey(
-                    "departments", "address_id",
-                    std::to_string(addrId),
-                    "addresses", "id",
-                    (int)i
-                );
-            }
-        }
+    void ValidateDepartmentsAddressFk(size_t threads, std::vector<DbConstraintError>& errors) const {
+        ValidateFk(departments_, addresses_, [](const Department& d) {return d.GetAddressId();},
+                   "departments", "address_id", "addresses", "id", threads, errors);
     }
 
-    void ValidateEmployeesDeptFk() const {
-        for (size_t i = 0; i < employees_.GetRowCount(); ++i) {
-            const auto& e = employees_.GetRow(i);
-            int deptId = e.GetDeptId();
-            if (!departments_.ContainsId(deptId)) {
-                throw DbConstraintError::ForeignKey(
-                    "employees", "dept_id",
-                    std::to_string(deptId),
-                    "departments", "id",
-                    (int)i
-                );
-            }
-        }
+    void ValidateEmployeesDeptFk(size_t threads, std::vector<DbConstraintError>& errors) const {
+        ValidateFk(employees_, departments_, [](const Employee& e) {return e.GetDeptId();},
+                   "employees", "dept_id", "departments", "id", threads, errors);
     }
 
-    void ValidateProductsDefaultSupplierFk() const {
-        for (size_t i = 0; i < products_.GetRowCount(); ++i) {
-            const auto& p = products_.GetRow(i);
-            int supId = p.GetDefaultSupplierId();
-            if (!suppliers_.ContainsId(supId)) {
-                throw DbConstraintError::ForeignKey(
-                    "products", "default_supplier_id",
-                    std::to_string(supId),
-                    "suppliers", "id",
-                    (int)i
-                );
-            }
-        }
+    void ValidateProductsDefaultSupplierFk(size_t threads, std::vector<DbConstraintError>& errors) const {
+        ValidateFk(products_, suppliers_, [](const Product& p) {return p.GetDefaultSupplierId();},
+                   "products", "default_supplier_id", "suppliers", "id", threads, errors);
     }
 
-    void ValidatePurchasesFk() const {
-        for (size_t i = 0; i < purchases_.GetRowCount(); ++i) {
-            const auto& pur = purchases_.GetRow(i);
-
-            if (!departments_.ContainsId(pur.GetDeptId())) {
-                throw DbConstraintError::ForeignKey(
-                    "purchases", "dept_id",
-                    std::to_string(pur.GetDeptId()),
-                    "departments", "id",
-                    (int)i
-                );
-            }
-            if (!suppliers_.ContainsId(pur.GetSupplierId())) {
-                throw DbConstraintError::ForeignKey(
-                    "purchases", "supplier_id",
-                    std::to_string(pur.GetSupplierId()),
-                    "suppliers", "id",
-                    (int)i
-                );
-            }
-            if (!products_.ContainsId(pur.GetProductId())) {
-                throw DbConstraintError::ForeignKey(
-                    "purchases", "product_id",
-                    std::to_string(pur.GetProductId()),
-                    "products", "id",
-                    (int)i
-                );
-            }
-        }
+    void ValidatePurchasesFk(size_t threads, std::vector<DbConstraintError>& errors) const {
+        ValidateFk(purchases_, departments_, [](const Purchase& p) {return p.GetDeptId();},
+                   "purchases", "dept_id", "departments", "id", threads, errors);
+        ValidateFk(purchases_, suppliers_, [](const Purchase& p) {return p.GetSupplierId();},
+                   "purchases", "supplier_id", "suppliers", "id", threads, errors);
+        ValidateFk(purchases_, products_, [](const Purchase& p) {return p.GetProductId();},
+                   "purchases", "product_id", "products", "id", threads, errors);
     }
 };
 
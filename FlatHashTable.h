@@ -0,0 +1,333 @@
+#ifndef LAZYDB_FLATHASHTABLE_H
+#define LAZYDB_FLATHASHTABLE_H
+
+#include <vector>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "core/KeyHash.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LAZYDB_FLATHASH_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Хеш-таблица с открытой адресацией в стиле Swiss table.
+// На каждый слот - один управляющий байт (пусто / удалён / 7 младших бит хеша),
+// поиск сравнивает сразу группу из 16 байт (SSE2) и трогает ключи только при совпадении.
+// Публичный API тот же, что у HashTable, поэтому её можно подставить вместо неё.
+// K и V должны иметь конструктор по умолчанию (слоты хранятся в обычном векторе).
+// Поиск гетерогенный, как в HashTable: для K = std::string подходит std::string_view.
+template<typename K, typename V>
+class FlatHashTable {
+public:
+    struct KeyValue {
+        K key;
+        V value;
+    };
+
+    // incrementalRehash = true: при росте старый массив не переносится целиком,
+    // а разбирается по несколько групп за каждую вставку/удаление (ровная задержка вставки)
+    FlatHashTable(size_t capacity = 16, double maxLoadFactor = 0.875, bool incrementalRehash = false) {
+        maxLoadFactor_ = (maxLoadFactor > 0.0 && maxLoadFactor < 0.875) ? maxLoadFactor : 0.875;
+        incremental_ = incrementalRehash;
+        Allocate(cur_, RoundCapacity(capacity));
+    }
+
+    size_t Size() const { return count_; }
+    size_t Capacity() const { return cur_.slots.size(); }
+    bool IsRehashing() const { return !old_.ctrl.empty(); }
+
+    void Clear() {
+        for (size_t i = 0; i < cur_.ctrl.size(); ++i) {
+            if (IsFull(cur_.ctrl[i])) cur_.slots[i] = KeyValue{};
+            cur_.ctrl[i] = kEmpty;
+        }
+        old_ = Storage{};
+        migrateNext_ = 0;
+        count_ = 0;
+        oldCount_ = 0;
+        deleted_ = 0;
+    }
+
+    template<typename Q = K>
+    bool Contains(const Q& key) const {
+        return GetPtr(key) != nullptr;
+    }
+
+    template<typename Q = K>
+    std::optional<V> Get(const Q& key) const {
+        const V* p = GetPtr(key);
+        if (!p) return std::nullopt;
+        return *p;
+    }
+
+    template<typename Q = K>
+    V* GetPtr(const Q& key) {
+        const FlatHashTable* self = this;
+        return const_cast<V*>(self->GetPtr(key));
+    }
+
+    template<typename Q = K>
+    const V* GetPtr(const Q& key) const {
+        const size_t h = HashOf(key);
+        size_t i = FindIndex(cur_, key, h);
+        if (i != npos) return &cur_.slots[i].value;
+        // во время переноса ключ может ещё лежать в старом массиве
+        if (IsRehashing() && (i = FindIndex(old_, key, h)) != npos) return &old_.slots[i].value;
+        return nullptr;
+    }
+
+    void Set(const K& key, V value) {
+        if (V* existing = GetPtr(key)) {
+            *existing = std::move(value);
+            return;
+        }
+        MigrateStep();
+        const size_t h = HashOf(key);
+        if (CurrentOccupied() + deleted_ + 1 > GrowthLimit()) {
+            // много надгробий - чистим, иначе растём в 2 раза
+            const size_t newCapacity = count_ + 1 > GrowthLimit() / 2 ? Capacity() * 2 : Capacity();
+            if (incremental_) {
+                StartIncrementalRehash(newCapacity);
+            } else {
+                Rehash(newCapacity);
+            }
+        }
+        const size_t i = FindInsertSlot(cur_, h);
+        if (cur_.ctrl[i] == kDeleted) --deleted_;
+        cur_.ctrl[i] = H2(h);
+        cur_.slots[i] = KeyValue{key, std::move(value)};
+        ++count_;
+    }
+
+    bool Remove(const K& key) {
+        const size_t h = HashOf(key);
+        bool removed = false;
+        size_t i = FindIndex(cur_, key, h);
+        if (i != npos) {
+            if (EraseAt(cur_, i)) ++deleted_;
+            removed = true;
+        } else if (IsRehashing() && (i = FindIndex(old_, key, h)) != npos) {
+            EraseAt(old_, i);
+            --oldCount_;
+            removed = true;
+        }
+        if (removed) --count_;
+        MigrateStep();
+        return removed;
+    }
+
+    template<typename F>
+    void ForEach(F&& fn) const {
+        for (const Storage* st : {&cur_, &old_}) {
+            for (size_t i = 0; i < st->ctrl.size(); ++i) {
+                if (IsFull(st->ctrl[i])) fn(st->slots[i].key, st->slots[i].value);
+            }
+        }
+    }
+
+    template<typename Q = K>
+    bool ContainsKey(const Q& key) const { return Contains(key); }
+    void Add(const K& key, const V& value) {Set(key, value); }
+    void Add(const K& key, V&& value) {Set(key, std::move(value)); }
+
+    template<typename Q = K>
+    V* TryGet(const Q& key) { return GetPtr(key); }
+    template<typename Q = K>
+    const V* TryGet(const Q& key) const { return GetPtr(key); }
+
+    template<typename Q = K>
+    bool TryGet(const Q& key, V& out) const {
+        const V* p = GetPtr(key);
+        if (!p) return false;
+        out = *p;
+        return true;
+    }
+
+    bool RemoveKey(const K& key) { return Remove(key); }
+
+    size_t GetCount() const { return Size(); }
+    size_t GetCapacity() const { return Capacity(); }
+
+private:
+    static constexpr size_t kGroupWidth = 16;
+    static constexpr size_t kMigrateGroupsPerOp = 2; // сколько старых групп переносим за одну операцию
+    static constexpr int8_t kEmpty = -128;  // 0b10000000
+    static constexpr int8_t kDeleted = -2;  // 0b11111110
+    // занятый слот: 0..127 (старший бит 0) = 7 бит хеша
+    static constexpr size_t npos = size_t(-1);
+
+    struct Storage {
+        std::vector<int8_t> ctrl;
+        std::vector<KeyValue> slots;
+    };
+
+    Storage cur_;
+    Storage old_;            // непустой только во время инкрементального переноса
+    size_t migrateNext_ = 0; // группы old_ до этого номера уже перенесены
+    size_t oldCount_ = 0;    // живых записей, ещё лежащих в old_
+    size_t count_ = 0;       // всего живых записей (cur_ + old_)
+    size_t deleted_ = 0;     // надгробий в cur_
+    double maxLoadFactor_ = 0.875;
+    bool incremental_ = false;
+
+    static bool IsFull(int8_t c) { return c >= 0; }
+
+    template<typename Q>
+    static size_t HashOf(const Q& key) {
+        // std::hash<int> - тождественная функция, поэтому перемешиваем биты,
+        // иначе 7 бит для ctrl и номер группы были бы почти одинаковыми
+        const size_t raw = KeyHash<K>{}(key);
+        uint64_t h = (uint64_t)raw * 0x9E3779B97F4A7C15ull;
+        return (size_t)(h ^ (h >> 29));
+    }
+    static int8_t H2(size_t h) { return (int8_t)(h & 0x7F); }
+    static size_t H1(size_t h) { return h >> 7; }
+
+    static size_t RoundCapacity(size_t capacity) {
+        size_t cap = kGroupWidth;
+        while (cap < capacity) cap *= 2;
+        return cap;
+    }
+
+    size_t GrowthLimit() const { return (size_t)(Capacity() * maxLoadFactor_); }
+    size_t CurrentOccupied() const { return count_ - oldCount_; }
+
+    static void Allocate(Storage& st, size_t capacity) {
+        st.ctrl.assign(capacity, kEmpty);
+        st.slots.assign(capacity, KeyValue{});
+    }
+
+    // битовая маска слотов группы, у которых управляющий байт равен c
+    static uint32_t MatchByte(const Storage& st, size_t group, int8_t c) {
+#ifdef LAZYDB_FLATHASH_SSE2
+        const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(st.ctrl.data() + group));
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+#else
+        uint32_t mask = 0;
+        for (size_t j = 0; j < kGroupWidth; ++j) {
+            if (st.ctrl[group + j] == c) mask |= 1u << j;
+        }
+        return mask;
+#endif
+    }
+
+    // пустые или удалённые (старший бит = 1)
+    static uint32_t MatchEmptyOrDeleted(const Storage& st, size_t group) {
+#ifdef LAZYDB_FLATHASH_SSE2
+        const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(st.ctrl.data() + group));
+        return (uint32_t)_mm_movemask_epi8(ctrl);
+#else
+        uint32_t mask = 0;
+        for (size_t j = 0; j < kGroupWidth; ++j) {
+            if (!IsFull(st.ctrl[group + j])) mask |= 1u << j;
+        }
+        return mask;
+#endif
+    }
+
+    static size_t LowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward(&idx, mask);
+        return idx;
+#else
+        return (size_t)__builtin_ctz(mask);
+#endif
+    }
+
+    // Пробирование по группам: g, g+1, g+3, g+6, ... (треугольные числа при
+    // числе групп = степень двойки обходят все группы)
+    template<typename Q>
+    static size_t FindIndex(const Storage& st, const Q& key, size_t h) {
+        const size_t groupMask = st.ctrl.size() / kGroupWidth - 1;
+        size_t g = H1(h) & groupMask;
+        const int8_t tag = H2(h);
+        for (size_t step = 1; step <= groupMask + 1; ++step) {
+            const size_t base = g * kGroupWidth;
+            for (uint32_t m = MatchByte(st, base, tag); m; m &= m - 1) {
+                const size_t i = base + LowestBit(m);
+                if (st.slots[i].key == key) return i;
+            }
+            if (MatchByte(st, base, kEmpty)) return npos;
+            g = (g + step) & groupMask;
+        }
+        return npos;
+    }
+
+    static size_t FindInsertSlot(const Storage& st, size_t h) {
+        const size_t groupMask = st.ctrl.size() / kGroupWidth - 1;
+        size_t g = H1(h) & groupMask;
+        for (size_t step = 1;; ++step) {
+            const size_t base = g * kGroupWidth;
+            const uint32_t m = MatchEmptyOrDeleted(st, base);
+            if (m) return base + LowestBit(m);
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // true - оставлено надгробие. Если в группе есть пустой слот, через неё ни один
+    // поиск не проходил дальше - можно сразу пометить слот пустым
+    static bool EraseAt(Storage& st, size_t i) {
+        const bool tombstone = MatchByte(st, i & ~(kGroupWidth - 1), kEmpty) == 0;
+        st.ctrl[i] = tombstone ? kDeleted : kEmpty;
+        st.slots[i] = KeyValue{};
+        return tombstone;
+    }
+
+    // запись переезжает в cur_ (ключ там заведомо отсутствует)
+    void MoveIntoCurrent(KeyValue& kv) {
+        const size_t h = HashOf(kv.key);
+        const size_t j = FindInsertSlot(cur_, h);
+        if (cur_.ctrl[j] == kDeleted) --deleted_;
+        cur_.ctrl[j] = H2(h);
+        cur_.slots[j] = std::move(kv); // переносим, а не копируем
+    }
+
+    void Rehash(size_t newCapacity) {
+        Storage old = std::move(cur_);
+        Allocate(cur_, RoundCapacity(newCapacity));
+        deleted_ = 0;
+        for (size_t i = 0; i < old.ctrl.size(); ++i) {
+            if (IsFull(old.ctrl[i])) MoveIntoCurrent(old.slots[i]);
+        }
+    }
+
+    void StartIncrementalRehash(size_t newCapacity) {
+        // предыдущий перенос к этому моменту почти всегда закончен; если нет - доводим его до конца
+        while (IsRehashing()) MigrateStep();
+        oldCount_ = count_;
+        old_ = std::move(cur_);
+        Allocate(cur_, RoundCapacity(newCapacity));
+        deleted_ = 0;
+        migrateNext_ = 0;
+    }
+
+    void MigrateStep() {
+        if (!IsRehashing()) return;
+        const size_t groups = old_.ctrl.size() / kGroupWidth;
+        for (size_t n = 0; n < kMigrateGroupsPerOp && migrateNext_ < groups; ++n, ++migrateNext_) {
+            const size_t base = migrateNext_ * kGroupWidth;
+            for (size_t i = base; i < base + kGroupWidth; ++i) {
+                if (!IsFull(old_.ctrl[i])) continue;
+                MoveIntoCurrent(old_.slots[i]);
+                // в old_ остаётся надгробие: поиск других ключей может идти через эту группу
+                old_.ctrl[i] = kDeleted;
+                --oldCount_;
+            }
+        }
+        if (migrateNext_ == groups) {
+            old_ = Storage{};
+            migrateNext_ = 0;
+        }
+    }
+};
+
+#endif // LAZYDB_FLATHASHTABLE_H
@@ -6,7 +6,14 @@
 #include <optional>
 #include <utility>
 #include <stdexcept>
-
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "core/KeyHash.h"
+
+// Поиск (Contains/Get/GetPtr/TryGet) гетерогенный: для K = std::string можно искать по
+// std::string_view или const char* без создания временной строки - хеш у них совпадает.
+// Ключ хешируется KeyHash: годятся и составные ключи (std::pair / std::tuple).
 template<typename K, typename V>
 class HashTable {
 public:
@@ -16,51 +23,55 @@ public:
     };
 
     using Bucket = std::vector<KeyValue>;
-    HashTable(size_t capacity = 16, double maxLoadFactor = 0.75) {
+    // incrementalRehash = true: при росте таблица держит старый и новый массивы корзин
+    // и переносит по несколько корзин за операцию вместо одного большого Rehash
+    HashTable(size_t capacity = 16, double maxLoadFactor = 0.75, bool incrementalRehash = false) {
         if (capacity < 1) {
             capacity = 1;
         }
         buckets_.resize(capacity);
         count_ = 0;
         maxLoadFactor_ = maxLoadFactor;
+        incremental_ = incrementalRehash;
     }
 
 
 
     size_t Size() const { return count_; }
     size_t Capacity() const { return buckets_.size(); }
+    bool IsRehashing() const { return !oldBuckets_.empty(); }
 
     void Clear() {
         for (auto& b : buckets_) b.clear();
+        oldBuckets_.clear();
+        migrateNext_ = 0;
         count_ = 0;
     }
 
-    bool Contains(const K& key) const {
+    template<typename Q = K>
+    bool Contains(const Q& key) const {
         return GetPtr(key) != nullptr;
     }
 
-    std::optional<V> Get(const K& key) const {
+    template<typename Q = K>
+    std::optional<V> Get(const Q& key) const {
         const V* p = GetPtr(key);
         if (!p) return std::nullopt;
         return *p;
     }
 
 
-    V* GetPtr(const K& key) {
-        if (buckets_.empty()) return nullptr;
-        auto& bucket = buckets_[bucketIndex(key, buckets_.size())];
-        for (auto& kv : bucket) {
-            if (kv.key == key) return &kv.value;
-        }
-        return nullptr;
+    template<typename Q = K>
+    V* GetPtr(const Q& key) {
+        const HashTable* self = this;
+        return const_cast<V*>(self->GetPtr(key));
     }
 
-    const V* GetPtr(const K& key) const {
-        if (buckets_.empty()) return nullptr;
-        const auto& bucket = buckets_[bucketIndex(key, buckets_.size())];
-        for (const auto& kv : bucket) {
-            if (kv.key == key) return &kv.value;
-        }
+    template<typename Q = K>
+    const V* GetPtr(const Q& key) const {
+        if (const KeyValue* kv = FindIn(buckets_, key)) return &kv->value;
+        // во время переноса ключ может ещё лежать в старой корзине
+        if (const KeyValue* kv = FindIn(oldBuckets_, key)) return &kv->value;
         return nullptr;
     }
 
@@ -70,6 +81,7 @@ public:
             return;
         }
 
+        MigrateStep();
         MaybeRehashForInsert();
         auto& bucket = buckets_[bucketIndex(key, buckets_.size())];
         bucket.push_back(KeyValue{key, std::move(value)});
@@ -77,17 +89,10 @@ public:
     }
 
     bool Remove(const K& key) {
-        if (buckets_.empty()) return false;
-        auto& bucket = buckets_[bucketIndex(key, buckets_.size())];
-        for (size_t i = 0; i < bucket.size(); ++i) {
-            if (bucket[i].key == key) {
-                bucket[i] = std::move(bucket.back());
-                bucket.pop_back();
-                --count_;
-                return true;
-            }
-        }
-        return false;
+        bool removed = RemoveFrom(buckets_, key) || RemoveFrom(oldBuckets_, key);
+        if (removed) --count_;
+        MigrateStep();
+        return removed;
     }
 
     template<typename F>
@@ -97,16 +102,40 @@ public:
                 fn(kv.key, kv.value);
             }
         }
+        for (size_t i = migrateNext_; i < oldBuckets_.size(); ++i) {
+            for (const auto& kv : oldBuckets_[i]) {
+                fn(kv.key, kv.value);
+            }
+        }
     }
 
-    bool ContainsKey(const K& key) const { return Contains(key); }
+    // то же, но значения можно менять (или забирать через std::move)
+    template<typename F>
+    void ForEach(F&& fn) {
+        for (auto& bucket : buckets_) {
+            for (auto& kv : bucket) {
+                fn(static_cast<const K&>(kv.key), kv.value);
+            }
+        }
+        for (size_t i = migrateNext_; i < oldBuckets_.size(); ++i) {
+            for (auto& kv : oldBuckets_[i]) {
+                fn(static_cast<const K&>(kv.key), kv.value);
+            }
+        }
+    }
+
+    template<typename Q = K>
+    bool ContainsKey(const Q& key) const { return Contains(key); }
     void Add(const K& key, const V& value) {Set(key, value); }
     void Add(const K& key, V&& value) {Set(key, std::move(value)); }
 
-    V* TryGet(const K& key) { return GetPtr(key); }
-    const V* TryGet(const K& key) const { return GetPtr(key); }
+    template<typename Q = K>
+    V* TryGet(const Q& key) { return GetPtr(key); }
+    template<typename Q = K>
+    const V* TryGet(const Q& key) const { return GetPtr(key); }
 
-    bool TryGet(const K& key, V& out) const {
+    template<typename Q = K>
+    bool TryGet(const Q& key, V& out) const {
         const V* p = GetPtr(key);
         if (!p) return false;
         out = *p;
@@ -119,12 +148,46 @@ public:
     size_t GetCapacity() const { return Capacity(); }
 
 private:
+    static constexpr size_t kMigrateBucketsPerOp = 4; // сколько старых корзин переносим за одну вставку/удаление
+
     std::vector<Bucket> buckets_;
+    std::vector<Bucket> oldBuckets_; // непустой только во время инкрементального переноса
+    size_t migrateNext_ = 0;         // корзины oldBuckets_ до этого номера уже перенесены
     size_t count_;
     double maxLoadFactor_;
+    bool incremental_ = false;
 
-    static size_t bucketIndex(const K& key, size_t cap) {
-        return std::hash<K>{}(key) % cap;
+    template<typename Q>
+    static size_t bucketIndex(const Q& key, size_t cap) {
+        return HashKey(key) % cap;
+    }
+
+    template<typename Q>
+    static size_t HashKey(const Q& key) {
+        return KeyHash<K>{}(key);
+    }
+
+    template<typename Q>
+    static const KeyValue* FindIn(const std::vector<Bucket>& buckets, const Q& key) {
+        if (buckets.empty()) return nullptr;
+        const auto& bucket = buckets[bucketIndex(key, buckets.size())];
+        for (const auto& kv : bucket) {
+            if (kv.key == key) return &kv;
+        }
+        return nullptr;
+    }
+
+    static bool RemoveFrom(std::vector<Bucket>& buckets, const K& key) {
+        if (buckets.empty()) return false;
+        auto& bucket = buckets[bucketIndex(key, buckets.size())];
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            if (bucket[i].key == key) {
+                bucket[i] = std::move(bucket.back());
+                bucket.pop_back();
+                return true;
+            }
+        }
+        return false;
     }
 
     void MaybeRehashForInsert() {
@@ -135,7 +198,11 @@ private:
         double loadFactor = double(count_ + 1) / double(cap);
 
         if (loadFactor > maxLoadFactor_) {
-            Rehash(cap * 2);   // увеличиваем таблицу в 2 раза
+            if (incremental_) {
+                StartIncrementalRehash(cap * 2);
+            } else {
+                Rehash(cap * 2);   // увеличиваем таблицу в 2 раза
+            }
         }
     }
 
@@ -144,15 +211,41 @@ private:
         if (newCapacity < 1) newCapacity = 1;
         std::vector<Bucket> newBuckets(newCapacity);
 
-        for (const auto& bucket : buckets_) {
-            for (const auto& kv : bucket) {
+        for (auto& bucket : buckets_) {
+            for (auto& kv : bucket) {
                 const size_t idx = bucketIndex(kv.key, newCapacity);
-                newBuckets[idx].push_back(kv);
+                newBuckets[idx].push_back(std::move(kv)); // переносим, а не копируем
             }
         }
         buckets_ = std::move(newBuckets);
         // count_ не меняется
     }
+
+    // старый массив становится oldBuckets_, дальше его корзины переносит MigrateStep
+    void StartIncrementalRehash(size_t newCapacity) {
+        // предыдущий перенос к этому моменту почти всегда закончен; если нет - доводим его до конца
+        while (IsRehashing()) MigrateStep();
+        oldBuckets_ = std::move(buckets_);
+        buckets_ = std::vector<Bucket>(newCapacity);
+        migrateNext_ = 0;
+    }
+
+    void MigrateStep() {
+        if (!IsRehashing()) return;
+        const size_t cap = buckets_.size();
+        for (size_t n = 0; n < kMigrateBucketsPerOp && migrateNext_ < oldBuckets_.size(); ++n, ++migrateNext_) {
+            Bucket& old = oldBuckets_[migrateNext_];
+            for (auto& kv : old) {
+                buckets_[bucketIndex(kv.key, cap)].push_back(std::move(kv));
+            }
+            Bucket().swap(old); // память старой корзины освобождаем сразу
+        }
+        if (migrateNext_ == oldBuckets_.size()) {
+            oldBuckets_.clear();
+            oldBuckets_.shrink_to_fit();
+            migrateNext_ = 0;
+        }
+    }
 };
 
 #endif // LAZYDB_HASHTABLE_H
@@ -3,25 +3,133 @@
 
 #include <vector>
 #include <functional>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <tuple>
+#include <type_traits>
 #include "core/HashTable.h"
+#include "core/FlatHashTable.h"
+#include "core/RoaringBitmap.h"
+#include "db/DbErrors.h"
 #include "db/BTree.h"
+#include "db/BPlusTree.h"
+#include "db/IntBPlusTree.h"
+#include "db/BulkLoad.h"
 
-// Ref "ссылка на строку"
+// Тип ключа для поиска по равенству: строки ищем по string_view (без временной std::string),
+// остальные ключи - по const K&
+template<typename K>
+struct IndexLookupKey { using type = const K&; };
+template<>
+struct IndexLookupKey<std::string> { using type = std::string_view; };
+
+// Невладеющий взгляд на список ссылок, хранящийся внутри индекса (аналог span).
+// Действителен, пока индекс не меняют: любой Insert/Remove/Build/Clear его инвалидирует.
+// Индекс, который хранит постинги не массивом (BitmapIndex), отдаёт view на расшифрованную
+// копию - тогда view сам держит её и живёт независимо от индекса.
+template<typename Ref>
+class PostingView {
+public:
+    PostingView() = default;
+    PostingView(const Ref* data, size_t size) : data_(data), size_(size) {}
+    explicit PostingView(const std::vector<Ref>* vec)
+        : data_(vec ? vec->data() : nullptr), size_(vec ? vec->size() : 0) {}
+    explicit PostingView(std::shared_ptr<const std::vector<Ref>> owned)
+        : PostingView(owned.get()) { owned_ = std::move(owned); }
+
+    const Ref* begin() const { return data_; }
+    const Ref* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Ref& operator[](size_t i) const { return data_[i]; }
+
+private:
+    const Ref* data_ = nullptr;
+    size_t size_ = 0;
+    std::shared_ptr<const std::vector<Ref>> owned_;
+};
+
+// Ссылка покрывающего индекса: слот строки плюс копия её PK (и, если заданы Cols, ещё столбцов),
+// чтобы запросы за id/проекцией брали всё из постингов, не трогая саму строку таблицы.
+// Равенство и порядок - только по слоту: Remove и сортировка постингов работают как со слотом
+template<typename... Cols>
+struct CoveringRef {
+    size_t slot;
+    int id;
+    std::tuple<Cols...> cols;
+};
+
+template<>
+struct CoveringRef<> { // только id - без пустого tuple в каждой ссылке
+    size_t slot;
+    int id;
+};
+
+template<typename... Cols>
+bool operator==(const CoveringRef<Cols...>& a, const CoveringRef<Cols...>& b) { return a.slot == b.slot; }
+template<typename... Cols>
+bool operator!=(const CoveringRef<Cols...>& a, const CoveringRef<Cols...>& b) { return a.slot != b.slot; }
+template<typename... Cols>
+bool operator<(const CoveringRef<Cols...>& a, const CoveringRef<Cols...>& b) { return a.slot < b.slot; }
+
+// слот строки, на которую указывает ссылка
+inline size_t SlotOfRef(size_t slot) { return slot; }
+template<typename... Cols>
+size_t SlotOfRef(const CoveringRef<Cols...>& ref) { return ref.slot; }
+
+// Ref "ссылка на строку" (слот или CoveringRef)
 template<typename K, typename Ref>
 class IIndex {
 public:
+    using RefType = Ref;
+
     virtual ~IIndex() {}
     virtual void Clear() = 0;
-    // Build по набору ссылок (slot)
+    // Build по набору ссылок (slot). Через интерфейс ключ достаётся косвенным вызовом std::function;
+    // у конкретных индексов есть шаблонный Build(refs, keySelector) - селектор встраивается
+    // и может возвращать const K& (ключ не копируется ради вызова)
     virtual void Build(const std::vector<Ref>& refs,
                        const std::function<K(Ref)>& keySelector) = 0;
     virtual void Insert(const K& key, Ref ref) = 0;
+    // убрать одну ссылку ref из записей ключа key (false - такой пары не было)
+    virtual bool Remove(const K& key, Ref ref) = 0;
+
+    using LookupKey = typename IndexLookupKey<K>::type;
+
+    // копия списка ссылок (удобно, если индекс потом будут менять)
+    std::vector<Ref> FindEquals(LookupKey key) const {
+        PostingView<Ref> view = FindEqualsView(key);
+        return std::vector<Ref>(view.begin(), view.end());
+    }
+
+    // без копирования: см. правила жизни PostingView
+    virtual PostingView<Ref> FindEqualsView(LookupKey key) const = 0;
 
-    virtual std::vector<Ref> FindEquals(const K& key) const = 0;
+    template<typename F>
+    void ForEachEqual(LookupKey key, F&& fn) const {
+        for (const Ref& r : FindEqualsView(key)) fn(r);
+    }
 
     virtual std::vector<Ref> FindRange(const K& from, const K& to) const = 0;
 };
 
+// Обычный режим: у каждого ключа свой std::vector<Ref>.
+// После массовой сборки индекс можно запечатать (Seal): все постинги переезжают в один массив
+// подряд по ключам (CSR), а в хеш-таблице остаются только (offset, length). Это убирает по
+// одному vector и куску кучи на ключ, и список ключа читается одним последовательным куском.
+// Правки запечатанного индекса не распечатывают его целиком: затронутый ключ переезжает из CSR
+// в обычную часть (map_) за O(длины его списка), поиск смотрит сначала в map_, потом в CSR.
+// Следующий Seal() сливает обе части. Уехавшие куски CSR до него остаются мёртвым местом -
+// не больше самого CSR, зато ни одна правка не перестраивает индекс целиком.
+// Remove - за O(1): последняя ссылка ключа переставляется на место удалённой (порядок постингов
+// после удалений не сохраняется), позицию ссылки даёт posOf_ (слот -> место в списке ключа).
+// posOf_ заполняется для ключа при первом Remove по нему (O(длины списка ключа)), так что Build
+// и Insert его не трогают
 template<typename K, typename Ref>
 class HashIndex : public IIndex<K, Ref> {
 public:
@@ -29,35 +137,139 @@ public:
 
     void Clear() override {
         map_.Clear();
+        sealedMap_.Clear();
+        sealedRefs_.clear();
+        sealedDead_ = 0;
+        posOf_.Clear();
+        sealed_ = false;
     }
 
     void Build(const std::vector<Ref>& refs,
-               const std::function<K(Ref)>& keySelector) override { //refs - ссылка на список ссылок на строки таблицы
+               const std::function<K(Ref)>& keySelector) override {
+        Build<const std::function<K(Ref)>&>(refs, keySelector);
+    }
+
+    template<typename KeySelector>
+    void Build(const std::vector<Ref>& refs, KeySelector&& keySelector) { //refs - ссылка на список ссылок на строки таблицы
         //keySelector  это функция, которая по ссылке на строку (Ref) возвращает ключ (K), по которому строится индекс.
         Clear();
         for (const Ref& r : refs) {
             Insert(keySelector(r), r);
         }
+        Seal();
     }
 
     void Insert(const K& key, Ref ref) override {
-        std::vector<Ref>* vec = map_.GetPtr(key);
-        if (!vec) {
-            map_.Set(key, std::vector<Ref>{ref});
+        Postings* p = MutablePostings(key);
+        if (!p) {
+            Postings fresh;
+            fresh.refs.push_back(ref);
+            map_.Set(key, std::move(fresh));
         } else {
-            vec->push_back(ref);
+            Append(*p, ref);
         }
     }
 
-    std::vector<Ref> FindEquals(const K& key) const override {
-        auto val = map_.Get(key);
-        if (!val) return {};
-        return *val;
+    bool Remove(const K& key, Ref ref) override {
+        Postings* p = MutablePostings(key);
+        if (!p) return false;
+        if (!p->positioned) Position(*p);
+        std::vector<Ref>& refs = p->refs;
+        const size_t* pos = posOf_.GetPtr(SlotOfRef(ref));
+        size_t i = pos ? *pos : refs.size();
+        if (i >= refs.size() || !(refs[i] == ref)) {
+            // позиция не сходится, только если одну ссылку вставляли дважды - тогда ищем честно
+            i = size_t(std::find(refs.begin(), refs.end(), ref) - refs.begin());
+            if (i == refs.size()) return false;
+        }
+        posOf_.Remove(SlotOfRef(ref));
+        if (i + 1 != refs.size()) {
+            refs[i] = std::move(refs.back());
+            posOf_.Set(SlotOfRef(refs[i]), i);
+        }
+        refs.pop_back();
+        if (refs.empty()) {
+            map_.Remove(key); // пустых списков в индексе не держим
+        }
+        return true;
+    }
+
+    // дописать постинги part в конец своих (part после этого пуст). Для сборки по кускам:
+    // если part построен по слотам после всех уже вставленных, порядок постингов как при Build
+    void MergeFrom(HashIndex&& part) {
+        if (part.sealed_) part.Unseal();
+        part.map_.ForEach([&](const K& key, Postings& refs) {
+            Postings* p = MutablePostings(key);
+            if (!p) {
+                refs.positioned = false; // позиции part считаны в его собственный posOf_
+                map_.Set(key, std::move(refs));
+            } else {
+                for (const Ref& r : refs.refs) Append(*p, r);
+            }
+        });
+        part.Clear();
+    }
+
+    // всё (живой остаток CSR и map_) - в один новый CSR
+    void Seal() {
+        if (sealed_ && map_.Size() == 0) return;
+        size_t total = sealedRefs_.size() - sealedDead_;
+        map_.ForEach([&](const K&, const Postings& p) {total += p.refs.size();});
+
+        HashTable<K, PostingRange> ranges((sealedMap_.Size() + map_.Size()) * 4 / 3 + 1);
+        std::vector<Ref> refs;
+        refs.reserve(total);
+        sealedMap_.ForEach([&](const K& key, const PostingRange& r) {
+            ranges.Add(key, PostingRange{refs.size(), r.length});
+            refs.insert(refs.end(), sealedRefs_.begin() + r.offset, sealedRefs_.begin() + (r.offset + r.length));
+        });
+        map_.ForEach([&](const K& key, const Postings& p) {
+            ranges.Add(key, PostingRange{refs.size(), p.refs.size()});
+            refs.insert(refs.end(), p.refs.begin(), p.refs.end());
+        });
+        sealedMap_ = std::move(ranges);
+        sealedRefs_ = std::move(refs);
+        sealedDead_ = 0;
+        map_ = HashTable<K, Postings>(1); // Clear оставил бы память корзин
+        posOf_ = FlatHashTable<size_t, size_t>(16, 0.875, true);
+        sealed_ = true;
+    }
+
+    // всё из CSR - в map_ (ключи map_ и CSR не пересекаются)
+    void Unseal() {
+        if (!sealed_) return;
+        if (map_.Size() == 0) map_ = HashTable<K, Postings>(sealedMap_.Size() * 4 / 3 + 1);
+        sealedMap_.ForEach([&](const K& key, const PostingRange& r) {
+            Postings p;
+            p.refs.assign(sealedRefs_.begin() + r.offset, sealedRefs_.begin() + (r.offset + r.length));
+            map_.Set(key, std::move(p));
+        });
+        sealedMap_ = HashTable<K, PostingRange>(1);
+        sealedRefs_ = std::vector<Ref>();
+        sealedDead_ = 0;
+        sealed_ = false;
+    }
+
+    // есть CSR-часть (правки после Seal могут лежать в map_ поверх неё)
+    bool IsSealed() const {return sealed_;}
+
+    using typename IIndex<K, Ref>::LookupKey;
+
+    PostingView<Ref> FindEqualsView(LookupKey key) const override {
+        if (map_.Size() != 0 || !sealed_) { // у только что запечатанного map_ пуст - лишний хеш не считаем
+            if (const Postings* p = map_.GetPtr(key)) return PostingView<Ref>(&p->refs);
+        }
+        if (sealed_) {
+            if (const PostingRange* r = sealedMap_.GetPtr(key)) {
+                return PostingView<Ref>(sealedRefs_.data() + r->offset, r->length);
+            }
+        }
+        return PostingView<Ref>();
     }
 
     std::vector<Ref> FindRange(const K& from, const K& to) const override {
         std::vector<Ref> out;
-        map_.ForEach([&](const K& k, const std::vector<Ref>& refs) {
+        ForEachKey([&](const K& k, PostingView<Ref> refs) {
             if (!(k < from) && !(to < k)) {
                 out.insert(out.end(), refs.begin(), refs.end());
             }
@@ -67,10 +279,227 @@ public:
     }
 
 private:
-    HashTable<K, std::vector<Ref>> map_;
+    struct PostingRange {
+        size_t offset;
+        size_t length;
+    };
+
+    struct Postings {
+        std::vector<Ref> refs;
+        bool positioned = false; // posOf_ заполнен для всех refs
+    };
+
+    HashTable<K, Postings> map_;
+    HashTable<K, PostingRange> sealedMap_{1};
+    std::vector<Ref> sealedRefs_;
+    size_t sealedDead_ = 0; // ссылок в sealedRefs_, чьи ключи уже переехали в map_
+    // слот -> позиция в refs своего ключа (для ключей с positioned); рост - инкрементальный, без пауз
+    FlatHashTable<size_t, size_t> posOf_{16, 0.875, true};
+    bool sealed_ = false;
+
+    // список ключа для правки (nullptr - ключа нет). Ключ из CSR сначала переезжает в map_
+    Postings* MutablePostings(const K& key) {
+        if (sealed_) {
+            if (const PostingRange* r = sealedMap_.GetPtr(key)) {
+                Postings p;
+                p.refs.assign(sealedRefs_.begin() + r->offset, sealedRefs_.begin() + (r->offset + r->length));
+                sealedDead_ += r->length;
+                sealedMap_.Remove(key);
+                map_.Set(key, std::move(p));
+            }
+        }
+        return map_.GetPtr(key);
+    }
+
+    void Append(Postings& p, const Ref& ref) {
+        if (p.positioned) posOf_.Set(SlotOfRef(ref), p.refs.size());
+        p.refs.push_back(ref);
+    }
+
+    void Position(Postings& p) {
+        for (size_t i = 0; i < p.refs.size(); ++i) posOf_.Set(SlotOfRef(p.refs[i]), i);
+        p.positioned = true;
+    }
+
+    template<typename F>
+    void ForEachKey(F&& fn) const {
+        if (sealed_) {
+            sealedMap_.ForEach([&](const K& k, const PostingRange& r) {
+                fn(k, PostingView<Ref>(sealedRefs_.data() + r.offset, r.length));
+            });
+        }
+        map_.ForEach([&](const K& k, const Postings& p) {fn(k, PostingView<Ref>(&p.refs));});
+    }
+};
+
+// Индекс с ограничением UNIQUE: на ключ ровно одна ссылка, хранится прямо в хеш-таблице.
+// Insert ключа, который уже занят другой ссылкой, бросает DbConstraintError::Unique (table/field
+// из конструктора). Чтобы не менять таблицу зря, проверить заранее - RequireFree;
+// для загрузки с накоплением ошибок - TryInsert (дубль не вставляется, оставляется первый)
+template<typename K, typename Ref>
+class UniqueHashIndex : public IIndex<K, Ref> {
+public:
+    using typename IIndex<K, Ref>::LookupKey;
+
+    UniqueHashIndex(std::string table, std::string field, size_t initialCapacity = 1024)
+        : map_(initialCapacity), table_(std::move(table)), field_(std::move(field)) {}
+
+    void Clear() override {
+        map_.Clear();
+    }
+
+    void Build(const std::vector<Ref>& refs,
+               const std::function<K(Ref)>& keySelector) override {
+        Build<const std::function<K(Ref)>&>(refs, keySelector);
+    }
+
+    template<typename KeySelector>
+    void Build(const std::vector<Ref>& refs, KeySelector&& keySelector) {
+        Clear();
+        for (const Ref& r : refs) {
+            Insert(keySelector(r), r);
+        }
+    }
+
+    void Insert(const K& key, Ref ref) override {
+        RequireFree(key, &ref);
+        map_.Set(key, ref);
+    }
+
+    // false - ключ уже занят другой ссылкой (индекс не меняется)
+    bool TryInsert(const K& key, Ref ref) {
+        if (const Ref* owner = map_.GetPtr(key)) return *owner == ref;
+        map_.Set(key, ref);
+        return true;
+    }
+
+    bool Remove(const K& key, Ref ref) override {
+        const Ref* owner = map_.GetPtr(key);
+        if (!owner || !(*owner == ref)) return false;
+        return map_.Remove(key);
+    }
+
+    // чья строка держит key (nullptr - свободен)
+    const Ref* Find(LookupKey key) const {
+        return map_.GetPtr(key);
+    }
+
+    // key свободен или занят самой self (при обновлении строки); иначе - ошибка UNIQUE
+    void RequireFree(LookupKey key, const Ref* self) const {
+        const Ref* owner = map_.GetPtr(key);
+        if (owner && !(self && *owner == *self)) {
+            throw DuplicateError(key, -1);
+        }
+    }
+
+    DbConstraintError DuplicateError(LookupKey key, int rowIndex) const {
+        if constexpr (std::is_same<K, std::string>::value) {
+            return DbConstraintError::Unique(table_, field_, std::string(key), rowIndex);
+        } else {
+            return DbConstraintError::Unique(table_, field_, std::to_string(key), rowIndex);
+        }
+    }
+
+    PostingView<Ref> FindEqualsView(LookupKey key) const override {
+        const Ref* owner = map_.GetPtr(key);
+        return owner ? PostingView<Ref>(owner, 1) : PostingView<Ref>();
+    }
+
+    std::vector<Ref> FindRange(const K& from, const K& to) const override {
+        std::vector<Ref> out;
+        map_.ForEach([&](const K& k, const Ref& r) {
+            if (!(k < from) && !(to < k)) {
+                out.push_back(r);
+            }
+        });
+        return out;
+    }
+
+private:
+    HashTable<K, Ref> map_;
+    std::string table_;
+    std::string field_;
 };
 
+// Индекс для столбцов с малым числом различных значений и длинными списками (FK вроде
+// purchases.dept_id): на ключ - сжатый битмап слотов вместо списка. Ref - номер слота (< 2^32).
+// Постинги всегда по возрастанию слота; FindBitmap + And/Or/AndNot из RoaringBitmap.h
+// пересекают условия по нескольким индексам без промежуточных векторов
 template<typename K, typename Ref>
+class BitmapIndex : public IIndex<K, Ref> {
+public:
+    BitmapIndex(size_t initialCapacity = 64): map_(initialCapacity) {}
+
+    void Clear() override {
+        map_.Clear();
+    }
+
+    void Build(const std::vector<Ref>& refs,
+               const std::function<K(Ref)>& keySelector) override {
+        Build<const std::function<K(Ref)>&>(refs, keySelector);
+    }
+
+    template<typename KeySelector>
+    void Build(const std::vector<Ref>& refs, KeySelector&& keySelector) {
+        Clear();
+        for (const Ref& r : refs) {
+            Insert(keySelector(r), r);
+        }
+    }
+
+    void Insert(const K& key, Ref ref) override {
+        RoaringBitmap* bm = map_.GetPtr(key);
+        if (!bm) {
+            RoaringBitmap fresh;
+            fresh.Add(uint32_t(ref));
+            map_.Set(key, std::move(fresh));
+        } else {
+            bm->Add(uint32_t(ref));
+        }
+    }
+
+    bool Remove(const K& key, Ref ref) override {
+        RoaringBitmap* bm = map_.GetPtr(key);
+        if (!bm || !bm->Remove(uint32_t(ref))) return false;
+        if (bm->Empty()) {
+            map_.Remove(key);
+        }
+        return true;
+    }
+
+    using typename IIndex<K, Ref>::LookupKey;
+
+    // nullptr - строк с таким ключом нет. Указатель живёт до следующей правки индекса
+    const RoaringBitmap* FindBitmap(LookupKey key) const {
+        return map_.GetPtr(key);
+    }
+
+    // для общих вызовов через IIndex: битмап расшифровывается в новый вектор (аллокация на каждый поиск).
+    // Кто знает, что индекс битмапный, берёт FindBitmap и обходит битмап сам (см. Database::BitmapToIds)
+    PostingView<Ref> FindEqualsView(LookupKey key) const override {
+        const RoaringBitmap* bm = map_.GetPtr(key);
+        if (!bm) return PostingView<Ref>();
+        return PostingView<Ref>(std::make_shared<const std::vector<Ref>>(bm->ToVector<Ref>()));
+    }
+
+    std::vector<Ref> FindRange(const K& from, const K& to) const override {
+        RoaringBitmap all;
+        map_.ForEach([&](const K& k, const RoaringBitmap& bm) {
+            if (!(k < from) && !(to < k)) {
+                all |= bm;
+            }
+        });
+        return all.ToVector<Ref>();
+    }
+
+private:
+    HashTable<K, RoaringBitmap> map_;
+};
+
+// Tree - BTree, BPlusTree (для длинных диапазонных запросов) или IntBPlusTree (int-ключи, SIMD-поиск)
+// Ключ может быть составным (std::tuple): порядок лексикографический, поэтому диапазон
+// {a, from}..{a, to} - это строки с первым полем a и вторым в [from, to]
+template<typename K, typename Ref, typename Tree = BTree<K, Ref>>
 class BTreeIndex : public IIndex<K, Ref> {
 public:
     BTreeIndex(size_t minDegree = 16)
@@ -82,18 +511,37 @@ public:
 
     void Build(const std::vector<Ref>& refs,
                const std::function<K(Ref)>& keySelector) override {
-        Clear();
+        Build<const std::function<K(Ref)>&>(refs, keySelector);
+    }
+
+    template<typename KeySelector>
+    void Build(const std::vector<Ref>& refs, KeySelector&& keySelector) {
+        std::vector<std::pair<K, Ref>> pairs;
+        pairs.reserve(refs.size());
         for (const Ref& r : refs) {
-            tree_.Insert(keySelector(r), r);
+            pairs.emplace_back(keySelector(r), r);
         }
+        BulkLoad(std::move(pairs));
+    }
+
+    // пересборка из пар (ключ, ссылка) без поштучных вставок: сортировка (threads > 1 - параллельная)
+    // и построение дерева снизу вверх с заполнением узлов fillFactor
+    void BulkLoad(std::vector<std::pair<K, Ref>> pairs, double fillFactor = 1.0, size_t threads = 1) {
+        tree_.BulkLoad(SortForBulkLoad(std::move(pairs), threads), fillFactor);
     }
 
     void Insert(const K& key, Ref ref) override {
         tree_.Insert(key, ref);
     }
 
-    std::vector<Ref> FindEquals(const K& key) const override {
-        return tree_.FindEquals(key);
+    bool Remove(const K& key, Ref ref) override {
+        return tree_.Remove(key, ref);
+    }
+
+    using typename IIndex<K, Ref>::LookupKey;
+
+    PostingView<Ref> FindEqualsView(LookupKey key) const override {
+        return PostingView<Ref>(tree_.FindPostings(key));
     }
 
     std::vector<Ref> FindRange(const K& from, const K& to) const override {
@@ -101,7 +549,58 @@ public:
     }
 
 private:
-    BTree<K, Ref> tree_;
+    Tree tree_;
+};
+
+// Индекс, который строится при первом чтении (Get): ровно один раз, даже если первыми
+// пришли несколько потоков сразу. Как именно строить, передаёт тот, кто читает (он знает таблицу
+// и ключ) - сама обёртка ни на что снаружи не ссылается и переносится вместе с базой.
+// Пока индекс не построен, правки строк его не трогают (IfBuilt() == nullptr): при первом
+// чтении он соберётся по текущему содержимому таблицы
+template<typename Index>
+class LazyIndex {
+public:
+    using IndexType = Index;
+
+    template<typename... Args>
+    explicit LazyIndex(Args&&... args) : index_(std::forward<Args>(args)...) {}
+
+    // перенос - только без одновременных обращений к индексу
+    LazyIndex(LazyIndex&& other) noexcept
+        : index_(std::move(other.index_)), built_(other.built_.load()) {}
+
+    LazyIndex& operator=(LazyIndex&& other) noexcept {
+        index_ = std::move(other.index_);
+        built_.store(other.built_.load());
+        return *this;
+    }
+
+    bool IsBuilt() const { return built_.load(std::memory_order_acquire); }
+
+    // build(Index&) вызывается только если индекс ещё не построен
+    template<typename BuildFn>
+    const Index& Get(BuildFn&& build) const {
+        if (!IsBuilt()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!built_.load(std::memory_order_relaxed)) {
+                build(index_);
+                built_.store(true, std::memory_order_release);
+            }
+        }
+        return index_;
+    }
+
+    // для поддержки при вставке/обновлении/удалении строк
+    Index* IfBuilt() { return IsBuilt() ? &index_ : nullptr; }
+
+    // прямой доступ для сборки снаружи (массовая сборка всех индексов); потом MarkBuilt
+    Index& Raw() { return index_; }
+    void MarkBuilt() { built_.store(true, std::memory_order_release); }
+
+private:
+    mutable Index index_;
+    mutable std::mutex mutex_;
+    mutable std::atomic<bool> built_{false};
 };
 
 #endif // LAZYDB_INDEX_H
@@ -0,0 +1,447 @@
+#ifndef LAZYDB_INTBPLUSTREE_H
+#define LAZYDB_INTBPLUSTREE_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <utility>
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#include "db/BulkLoad.h"
+
+
+// B+ дерево для int-ключей с "плоскими" узлами: ключи лежат в массиве прямо внутри узла,
+// выровненном по кэш-линии, а поиск внутри узла - линейное SIMD-сравнение (AVX2/SSE2)
+// вместо std::lower_bound. Размер узла задаётся при компиляции (MinDegree),
+// аргумент конструктора оставлен только для совместимости с BTreeIndex.
+template<typename Ref, int MinDegree = 16>
+class IntBPlusTree {
+    static_assert(MinDegree >= 2, "MinDegree must be >= 2");
+public:
+    using K = int;
+
+    IntBPlusTree(int /*minDegree*/ = MinDegree) : root_(new Leaf()) {}
+
+    void Clear() {
+        root_.reset(new Leaf());
+    }
+
+    void Insert(K key, Ref ref) {
+        K upKey;
+        NodePtr right = InsertInto(*root_, key, ref, upKey);
+        if (right) {
+            Inner* newRoot = new Inner();
+            newRoot->keys[0] = upKey;
+            newRoot->count = 1;
+            newRoot->children[0] = std::move(root_);
+            newRoot->children[1] = std::move(right);
+            root_.reset(newRoot);
+        }
+    }
+
+    // убрать ref из списка значений key; если список опустел - удаляем и сам ключ
+    bool Remove(K key, Ref ref) {
+        Leaf* leaf = FindLeaf(key);
+        const size_t i = LowerBound(leaf->keys, leaf->count, key);
+        if (i == leaf->count || leaf->keys[i] != key) return false;
+
+        std::vector<Ref>& vec = leaf->values[i];
+        auto it = std::find(vec.begin(), vec.end(), ref);
+        if (it == vec.end()) return false;
+        vec.erase(it);
+        if (vec.empty()) {
+            EraseKey(key);
+        }
+        return true;
+    }
+
+    bool EraseKey(K key) {
+        bool erased = DeleteFromNode(*root_, key);
+        if (!root_->leaf && root_->count == 0) {
+            NodePtr child = std::move(AsInner(*root_).children[0]);
+            root_ = std::move(child);
+        }
+        return erased;
+    }
+
+    // Построение снизу вверх из уникальных ключей по возрастанию (см. SortForBulkLoad):
+    // листья заполняются на fillFactor и связываются в список, выше - упакованные внутренние уровни
+    void BulkLoad(std::vector<std::pair<K, std::vector<Ref>>>&& entries, double fillFactor = 1.0) {
+        Clear();
+        if (entries.empty()) return;
+
+        std::vector<NodePtr> level;
+        std::vector<K> lows; // наименьший ключ поддерева каждого узла уровня
+        const size_t n = entries.size();
+        const size_t leaves = PackedNodeCount(n, MaxKeys, MinKeys, fillFactor);
+        Leaf* prev = nullptr;
+        for (size_t i = 0, pos = 0; i < leaves; ++i) {
+            Leaf* leaf = new Leaf();
+            level.emplace_back(leaf);
+            leaf->count = PackedNodeSize(n, leaves, i);
+            for (size_t j = 0; j < leaf->count; ++j, ++pos) {
+                leaf->keys[j] = entries[pos].first;
+                leaf->values[j] = std::move(entries[pos].second);
+            }
+            leaf->prev = prev;
+            if (prev) prev->next = leaf;
+            prev = leaf;
+            lows.push_back(leaf->keys[0]);
+        }
+
+        while (level.size() > 1) {
+            const size_t m = level.size();
+            const size_t parents = PackedNodeCount(m, MaxKeys + 1, MinKeys + 1, fillFactor);
+            std::vector<NodePtr> upper;
+            std::vector<K> upperLows;
+            for (size_t i = 0, c = 0; i < parents; ++i) {
+                const size_t cnt = PackedNodeSize(m, parents, i);
+                Inner* node = new Inner();
+                upper.emplace_back(node);
+                upperLows.push_back(lows[c]);
+                for (size_t j = 0; j < cnt; ++j, ++c) {
+                    if (j > 0) node->keys[j - 1] = lows[c];
+                    node->children[j] = std::move(level[c]);
+                }
+                node->count = cnt - 1;
+            }
+            level = std::move(upper);
+            lows = std::move(upperLows);
+        }
+        root_ = std::move(level.front());
+    }
+
+    std::vector<Ref> FindEquals(K key) const {
+        const std::vector<Ref>* vec = FindPostings(key);
+        if (!vec) return {};
+        return *vec;
+    }
+
+    // список значений key без копирования (nullptr - ключа нет); живёт до следующего изменения дерева
+    const std::vector<Ref>* FindPostings(K key) const {
+        const Leaf* leaf = FindLeaf(key);
+        const size_t i = LowerBound(leaf->keys, leaf->count, key);
+        if (i == leaf->count || leaf->keys[i] != key) return nullptr;
+        return &leaf->values[i];
+    }
+
+    std::vector<Ref> FindRange(K from, K to) const {
+        std::vector<Ref> out;
+        const Leaf* leaf = FindLeaf(from);
+        size_t i = LowerBound(leaf->keys, leaf->count, from);
+        while (leaf) {
+            for (; i < leaf->count; ++i) {
+                if (leaf->keys[i] > to) return out;
+                out.insert(out.end(), leaf->values[i].begin(), leaf->values[i].end());
+            }
+            leaf = leaf->next;
+            i = 0;
+        }
+        return out;
+    }
+
+private:
+    static constexpr size_t MaxKeys = 2 * MinDegree - 1;
+    static constexpr size_t MinKeys = MinDegree - 1;
+    // +1 ключ на время вставки до split, округляем до 16 int = 64 байта (кэш-линия)
+    static constexpr size_t KeySlots = (MaxKeys + 1 + 15) / 16 * 16;
+    static constexpr K Sentinel = INT_MAX; // хвост массива ключей, нужен для SIMD-поиска без проверки границ
+
+    struct Node;
+    struct NodeDeleter {
+        void operator()(Node* n) const;
+    };
+    using NodePtr = std::unique_ptr<Node, NodeDeleter>;
+
+    struct Node {
+        explicit Node(bool leaf) : leaf(leaf) {
+            std::fill(keys, keys + KeySlots, Sentinel);
+        }
+        alignas(64) K keys[KeySlots]; // отсортированы, keys[count..] == Sentinel
+        size_t count = 0;
+        bool leaf;
+    };
+
+    struct Leaf : Node {
+        Leaf() : Node(true) {}
+        std::vector<Ref> values[MaxKeys + 1];
+        Leaf* prev = nullptr;
+        Leaf* next = nullptr;
+    };
+
+    struct Inner : Node {
+        Inner() : Node(false) {}
+        NodePtr children[MaxKeys + 2]; // в children[i] ключи из [keys[i-1], keys[i])
+    };
+
+    NodePtr root_;
+
+    static Leaf& AsLeaf(Node& n) { return static_cast<Leaf&>(n); }
+    static Inner& AsInner(Node& n) { return static_cast<Inner&>(n); }
+    static const Leaf& AsLeaf(const Node& n) { return static_cast<const Leaf&>(n); }
+    static const Inner& AsInner(const Node& n) { return static_cast<const Inner&>(n); }
+
+    // число ключей < key (Inclusive: <= key). Ключи отсортированы, поэтому маска сравнения
+    // в каждой группе - это префикс из единиц; первая неполная группа даёт ответ
+    template<bool Inclusive>
+    static size_t Rank(const K* keys, size_t n, K key) {
+#if defined(__AVX2__)
+        const __m256i kv = _mm256_set1_epi32(key);
+        for (size_t i = 0; i < n; i += 8) {
+            const __m256i block = _mm256_load_si256(reinterpret_cast<const __m256i*>(keys + i));
+            __m256i lt = Inclusive ? _mm256_cmpgt_epi32(block, kv) : _mm256_cmpgt_epi32(kv, block);
+            unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(lt));
+            if (Inclusive) mask = ~mask & 0xFFu;
+            if (mask != 0xFFu) return std::min(n, i + CountOnes(mask));
+        }
+        return n;
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i kv = _mm_set1_epi32(key);
+        for (size_t i = 0; i < n; i += 4) {
+            const __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(keys + i));
+            __m128i lt = Inclusive ? _mm_cmpgt_epi32(block, kv) : _mm_cmpgt_epi32(kv, block);
+            unsigned mask = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(lt));
+            if (Inclusive) mask = ~mask & 0xFu;
+            if (mask != 0xFu) return std::min(n, i + CountOnes(mask));
+        }
+        return n;
+#else
+        size_t i = 0;
+        while (i < n && (Inclusive ? keys[i] <= key : keys[i] < key)) ++i;
+        return i;
+#endif
+    }
+
+    static size_t CountOnes(unsigned mask) {
+        size_t c = 0;
+        for (; mask; mask &= mask - 1) ++c;
+        return c;
+    }
+
+    static size_t LowerBound(const K* keys, size_t n, K key) { return Rank<false>(keys, n, key); }
+    static size_t ChildIndex(const K* keys, size_t n, K key) { return Rank<true>(keys, n, key); }
+
+    const Leaf* FindLeaf(K key) const {
+        const Node* x = root_.get();
+        while (!x->leaf) {
+            x = AsInner(*x).children[ChildIndex(x->keys, x->count, key)].get();
+        }
+        return &AsLeaf(*x);
+    }
+
+    Leaf* FindLeaf(K key) {
+        const IntBPlusTree* self = this;
+        return const_cast<Leaf*>(self->FindLeaf(key));
+    }
+
+    // сдвиг a[pos..count) на одну позицию вправо / влево (a[pos] затирается)
+    template<typename T>
+    static void ShiftRight(T* a, size_t count, size_t pos) {
+        std::move_backward(a + pos, a + count, a + count + 1);
+    }
+    template<typename T>
+    static void ShiftLeft(T* a, size_t count, size_t pos) {
+        std::move(a + pos + 1, a + count, a + pos);
+    }
+
+    NodePtr InsertInto(Node& x, K key, Ref ref, K& upKey) {
+        if (x.leaf) {
+            Leaf& leaf = AsLeaf(x);
+            const size_t pos = LowerBound(leaf.keys, leaf.count, key);
+            if (pos < leaf.count && leaf.keys[pos] == key) {
+                leaf.values[pos].push_back(ref);
+                return nullptr;
+            }
+            ShiftRight(leaf.keys, leaf.count, pos);
+            ShiftRight(leaf.values, leaf.count, pos);
+            leaf.keys[pos] = key;
+            leaf.values[pos] = std::vector<Ref>{ref};
+            leaf.count++;
+            if (leaf.count <= MaxKeys) return nullptr;
+            return SplitLeaf(leaf, upKey);
+        }
+
+        Inner& in = AsInner(x);
+        const size_t i = ChildIndex(in.keys, in.count, key);
+        K childUpKey;
+        NodePtr right = InsertInto(*in.children[i], key, ref, childUpKey);
+        if (!right) return nullptr;
+
+        ShiftRight(in.keys, in.count, i);
+        ShiftRight(in.children, in.count + 1, i + 1);
+        in.keys[i] = childUpKey;
+        in.children[i + 1] = std::move(right);
+        in.count++;
+        if (in.count <= MaxKeys) return nullptr;
+        return SplitInternal(in, upKey);
+    }
+
+    NodePtr SplitLeaf(Leaf& x, K& upKey) {
+        Leaf* z = new Leaf();
+        const size_t mid = x.count / 2;
+        for (size_t j = mid; j < x.count; ++j) {
+            z->keys[j - mid] = x.keys[j];
+            z->values[j - mid] = std::move(x.values[j]);
+            x.keys[j] = Sentinel;
+            x.values[j].clear();
+        }
+        z->count = x.count - mid;
+        x.count = mid;
+
+        z->next = x.next;
+        z->prev = &x;
+        if (x.next) x.next->prev = z;
+        x.next = z;
+
+        upKey = z->keys[0];
+        return NodePtr(z);
+    }
+
+    NodePtr SplitInternal(Inner& x, K& upKey) {
+        Inner* z = new Inner();
+        const size_t mid = x.count / 2;
+        upKey = x.keys[mid];
+        for (size_t j = mid + 1; j < x.count; ++j) {
+            z->keys[j - mid - 1] = x.keys[j];
+        }
+        for (size_t j = mid + 1; j <= x.count; ++j) {
+            z->children[j - mid - 1] = std::move(x.children[j]);
+        }
+        z->count = x.count - mid - 1;
+        std::fill(x.keys + mid, x.keys + x.count, Sentinel);
+        x.count = mid;
+        return NodePtr(z);
+    }
+
+    bool DeleteFromNode(Node& x, K key) {
+        if (x.leaf) {
+            Leaf& leaf = AsLeaf(x);
+            const size_t i = LowerBound(leaf.keys, leaf.count, key);
+            if (i == leaf.count || leaf.keys[i] != key) return false;
+            ShiftLeft(leaf.keys, leaf.count, i);
+            ShiftLeft(leaf.values, leaf.count, i);
+            leaf.count--;
+            leaf.keys[leaf.count] = Sentinel;
+            leaf.values[leaf.count].clear();
+            return true;
+        }
+
+        Inner& in = AsInner(x);
+        const size_t i = ChildIndex(in.keys, in.count, key);
+        if (!DeleteFromNode(*in.children[i], key)) return false;
+        if (in.children[i]->count < MinKeys) {
+            FixUnderflow(in, i);
+        }
+        return true;
+    }
+
+    void FixUnderflow(Inner& x, size_t i) {
+        if (i > 0 && x.children[i - 1]->count > MinKeys) {
+            BorrowFromLeft(x, i);
+        } else if (i < x.count && x.children[i + 1]->count > MinKeys) {
+            BorrowFromRight(x, i);
+        } else if (i < x.count) {
+            MergeChildren(x, i);
+        } else {
+            MergeChildren(x, i - 1);
+        }
+    }
+
+    void BorrowFromLeft(Inner& x, size_t i) {
+        Node& child = *x.children[i];
+        Node& sib = *x.children[i - 1];
+        ShiftRight(child.keys, child.count, 0);
+        if (child.leaf) {
+            Leaf& c = AsLeaf(child);
+            Leaf& s = AsLeaf(sib);
+            ShiftRight(c.values, c.count, 0);
+            c.keys[0] = s.keys[s.count - 1];
+            c.values[0] = std::move(s.values[s.count - 1]);
+            s.values[s.count - 1].clear();
+            x.keys[i - 1] = c.keys[0];
+        } else {
+            Inner& c = AsInner(child);
+            Inner& s = AsInner(sib);
+            ShiftRight(c.children, c.count + 1, 0);
+            c.keys[0] = x.keys[i - 1];
+            c.children[0] = std::move(s.children[s.count]);
+            x.keys[i - 1] = s.keys[s.count - 1];
+        }
+        child.count++;
+        sib.count--;
+        sib.keys[sib.count] = Sentinel;
+    }
+
+    void BorrowFromRight(Inner& x, size_t i) {
+        Node& child = *x.children[i];
+        Node& sib = *x.children[i + 1];
+        if (child.leaf) {
+            Leaf& c = AsLeaf(child);
+            Leaf& s = AsLeaf(sib);
+            c.keys[c.count] = s.keys[0];
+            c.values[c.count] = std::move(s.values[0]);
+            ShiftLeft(s.keys, s.count, 0);
+            ShiftLeft(s.values, s.count, 0);
+            s.values[s.count - 1].clear();
+            x.keys[i] = s.keys[0];
+        } else {
+            Inner& c = AsInner(child);
+            Inner& s = AsInner(sib);
+            c.keys[c.count] = x.keys[i];
+            c.children[c.count + 1] = std::move(s.children[0]);
+            x.keys[i] = s.keys[0];
+            ShiftLeft(s.keys, s.count, 0);
+            ShiftLeft(s.children, s.count + 1, 0);
+        }
+        child.count++;
+        sib.count--;
+        sib.keys[sib.count] = Sentinel;
+    }
+
+    // children[i+1] вливается в children[i]
+    void MergeChildren(Inner& x, size_t i) {
+        Node& left = *x.children[i];
+        Node& right = *x.children[i + 1];
+        if (left.leaf) {
+            Leaf& l = AsLeaf(left);
+            Leaf& r = AsLeaf(right);
+            for (size_t j = 0; j < r.count; ++j) {
+                l.keys[l.count + j] = r.keys[j];
+                l.values[l.count + j] = std::move(r.values[j]);
+            }
+            l.count += r.count;
+            l.next = r.next;
+            if (r.next) r.next->prev = &l;
+        } else {
+            Inner& l = AsInner(left);
+            Inner& r = AsInner(right);
+            l.keys[l.count] = x.keys[i];
+            for (size_t j = 0; j < r.count; ++j) {
+                l.keys[l.count + 1 + j] = r.keys[j];
+            }
+            for (size_t j = 0; j <= r.count; ++j) {
+                l.children[l.count + 1 + j] = std::move(r.children[j]);
+            }
+            l.count += r.count + 1;
+        }
+        ShiftLeft(x.keys, x.count, i);
+        x.children[i + 1].reset();
+        ShiftLeft(x.children, x.count + 1, i + 1);
+        x.count--;
+        x.keys[x.count] = Sentinel;
+    }
+};
+
+template<typename Ref, int MinDegree>
+void IntBPlusTree<Ref, MinDegree>::NodeDeleter::operator()(Node* n) const {
+    if (n->leaf) {
+        delete static_cast<Leaf*>(n);
+    } else {
+        delete static_cast<Inner*>(n);
+    }
+}
+
+#endif // LAZYDB_INTBPLUSTREE_H
@@ -0,0 +1,47 @@
+#ifndef LAZYDB_KEYHASH_H
+#define LAZYDB_KEYHASH_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <cstddef>
+
+// Хеш ключа для HashTable / FlatHashTable.
+// По умолчанию std::hash<K>; строки хешируются как string_view (std::hash<std::string> и
+// std::hash<std::string_view> совпадают), поэтому искать можно без временной std::string.
+// Составные ключи (std::pair, std::tuple) - хеши полей смешиваются по порядку полей
+template<typename K>
+struct KeyHash {
+    size_t operator()(const K& key) const { return std::hash<K>{}(key); }
+};
+
+template<>
+struct KeyHash<std::string> {
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+};
+
+inline size_t HashCombine(size_t seed, size_t h) {
+    return seed ^ (h + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+
+template<typename A, typename B>
+struct KeyHash<std::pair<A, B>> {
+    size_t operator()(const std::pair<A, B>& key) const {
+        return HashCombine(KeyHash<A>{}(key.first), KeyHash<B>{}(key.second));
+    }
+};
+
+template<typename... Ts>
+struct KeyHash<std::tuple<Ts...>> {
+    size_t operator()(const std::tuple<Ts...>& key) const {
+        return std::apply([](const Ts&... fields) {
+            size_t seed = 0;
+            ((seed = HashCombine(seed, KeyHash<Ts>{}(fields))), ...);
+            return seed;
+        }, key);
+    }
+};
+
+#endif // LAZYDB_KEYHASH_H
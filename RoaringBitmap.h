@@ -0,0 +1,358 @@
+#ifndef LAZYDB_ROARINGBITMAP_H
+#define LAZYDB_ROARINGBITMAP_H
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Сжатое множество uint32 (слотов таблицы) в стиле Roaring.
+// Числа делятся по старшим 16 битам на контейнеры; контейнер хранит младшие 16 бит:
+// - до kMaxArray значений - отсортированный массив uint16 (2 байта на значение),
+// - больше - битсет на 65536 бит (8 КБ), AND/OR/ANDNOT по 64 бита за раз.
+// Контейнеры лежат по возрастанию старших бит, поэтому обход и операции идут слиянием
+class RoaringBitmap {
+public:
+    RoaringBitmap() {}
+
+    bool Empty() const { return containers_.empty(); }
+
+    size_t Cardinality() const {
+        size_t n = 0;
+        for (const Container& c : containers_) n += c.card;
+        return n;
+    }
+
+    void Clear() { containers_.clear(); }
+
+    void Add(uint32_t x) {
+        const uint16_t high = uint16_t(x >> 16);
+        const uint16_t low = uint16_t(x & 0xFFFF);
+        auto it = LowerBound(high);
+        if (it == containers_.end() || it->high != high) {
+            it = containers_.insert(it, Container{});
+            it->high = high;
+        }
+        Container& c = *it;
+        if (c.IsBitmap()) {
+            uint64_t& w = c.bits[low >> 6];
+            const uint64_t mask = uint64_t(1) << (low & 63);
+            if (!(w & mask)) {
+                w |= mask;
+                ++c.card;
+            }
+            return;
+        }
+        // слоты обычно приходят по возрастанию - тогда это push_back
+        if (c.array.empty() || c.array.back() < low) {
+            c.array.push_back(low);
+        } else {
+            auto pos = std::lower_bound(c.array.begin(), c.array.end(), low);
+            if (*pos == low) return;
+            c.array.insert(pos, low);
+        }
+        ++c.card;
+        if (c.card > kMaxArray) ToBitmap(c);
+    }
+
+    bool Remove(uint32_t x) {
+        const uint16_t high = uint16_t(x >> 16);
+        const uint16_t low = uint16_t(x & 0xFFFF);
+        auto it = LowerBound(high);
+        if (it == containers_.end() || it->high != high) return false;
+        Container& c = *it;
+        if (c.IsBitmap()) {
+            uint64_t& w = c.bits[low >> 6];
+            const uint64_t mask = uint64_t(1) << (low & 63);
+            if (!(w & mask)) return false;
+            w &= ~mask;
+            --c.card;
+        } else {
+            auto pos = std::lower_bound(c.array.begin(), c.array.end(), low);
+            if (pos == c.array.end() || *pos != low) return false;
+            c.array.erase(pos);
+            --c.card;
+        }
+        if (c.card == 0) {
+            containers_.erase(it);
+        } else {
+            Normalize(c);
+        }
+        return true;
+    }
+
+    bool Contains(uint32_t x) const {
+        const uint16_t high = uint16_t(x >> 16);
+        auto it = std::lower_bound(containers_.begin(), containers_.end(), high,
+                                   [](const Container& c, uint16_t h) {return c.high < h;});
+        return it != containers_.end() && it->high == high && it->Contains(uint16_t(x & 0xFFFF));
+    }
+
+    // наименьшее значение (множество не пусто)
+    uint32_t Min() const {
+        const Container& c = containers_.front();
+        uint16_t low = 0;
+        if (c.IsBitmap()) {
+            size_t w = 0;
+            while (!c.bits[w]) ++w;
+            low = uint16_t(w * 64 + Ctz(c.bits[w]));
+        } else {
+            low = c.array.front();
+        }
+        return (uint32_t(c.high) << 16) | low;
+    }
+
+    // обход по возрастанию
+    template<typename F>
+    void ForEach(F&& fn) const {
+        for (const Container& c : containers_) {
+            const uint32_t base = uint32_t(c.high) << 16;
+            if (c.IsBitmap()) {
+                for (size_t w = 0; w < kWords; ++w) {
+                    uint64_t bits = c.bits[w];
+                    while (bits) {
+                        fn(base | uint32_t(w * 64 + Ctz(bits)));
+                        bits &= bits - 1;
+                    }
+                }
+            } else {
+                for (uint16_t low : c.array) fn(base | low);
+            }
+        }
+    }
+
+    template<typename T = uint32_t>
+    std::vector<T> ToVector() const {
+        std::vector<T> out;
+        out.reserve(Cardinality());
+        ForEach([&](uint32_t x) {out.push_back(T(x));});
+        return out;
+    }
+
+    // байт под данные контейнеров (без заголовков векторов) - для сравнения с обычными списками
+    size_t MemoryBytes() const {
+        size_t n = containers_.capacity() * sizeof(Container);
+        for (const Container& c : containers_) {
+            n += c.array.capacity() * sizeof(uint16_t) + c.bits.capacity() * sizeof(uint64_t);
+        }
+        return n;
+    }
+
+    friend RoaringBitmap And(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap out;
+        auto i = a.containers_.begin();
+        auto j = b.containers_.begin();
+        while (i != a.containers_.end() && j != b.containers_.end()) {
+            if (i->high < j->high) {
+                ++i;
+            } else if (j->high < i->high) {
+                ++j;
+            } else {
+                Container c = AndContainers(*i, *j);
+                if (c.card) out.containers_.push_back(std::move(c));
+                ++i;
+                ++j;
+            }
+        }
+        return out;
+    }
+
+    friend RoaringBitmap Or(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap out;
+        out.containers_.reserve(a.containers_.size() + b.containers_.size());
+        auto i = a.containers_.begin();
+        auto j = b.containers_.begin();
+        while (i != a.containers_.end() || j != b.containers_.end()) {
+            if (j == b.containers_.end() || (i != a.containers_.end() && i->high < j->high)) {
+                out.containers_.push_back(*i++);
+            } else if (i == a.containers_.end() || j->high < i->high) {
+                out.containers_.push_back(*j++);
+            } else {
+                out.containers_.push_back(OrContainers(*i, *j));
+                ++i;
+                ++j;
+            }
+        }
+        return out;
+    }
+
+    // a без b
+    friend RoaringBitmap AndNot(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap out;
+        auto j = b.containers_.begin();
+        for (const Container& c : a.containers_) {
+            while (j != b.containers_.end() && j->high < c.high) ++j;
+            if (j == b.containers_.end() || j->high != c.high) {
+                out.containers_.push_back(c);
+                continue;
+            }
+            Container d = AndNotContainers(c, *j);
+            if (d.card) out.containers_.push_back(std::move(d));
+        }
+        return out;
+    }
+
+    RoaringBitmap& operator&=(const RoaringBitmap& other) { return *this = And(*this, other); }
+    RoaringBitmap& operator|=(const RoaringBitmap& other) { return *this = Or(*this, other); }
+    RoaringBitmap& operator-=(const RoaringBitmap& other) { return *this = AndNot(*this, other); }
+
+    bool operator==(const RoaringBitmap& other) const {
+        if (containers_.size() != other.containers_.size()) return false;
+        for (size_t i = 0; i < containers_.size(); ++i) {
+            const Container& x = containers_[i];
+            const Container& y = other.containers_[i];
+            if (x.high != y.high || x.card != y.card || x.array != y.array || x.bits != y.bits) return false;
+        }
+        return true;
+    }
+    bool operator!=(const RoaringBitmap& other) const { return !(*this == other); }
+
+private:
+    static constexpr size_t kMaxArray = 4096; // дальше битсет (8 КБ) компактнее массива
+    static constexpr size_t kWords = 65536 / 64;
+
+    struct Container {
+        uint16_t high = 0;
+        uint32_t card = 0;
+        std::vector<uint16_t> array; // режим массива (bits пуст)
+        std::vector<uint64_t> bits;  // режим битсета: kWords слов
+
+        bool IsBitmap() const { return !bits.empty(); }
+
+        bool Contains(uint16_t low) const {
+            if (IsBitmap()) return (bits[low >> 6] >> (low & 63)) & 1;
+            return std::binary_search(array.begin(), array.end(), low);
+        }
+    };
+
+    std::vector<Container> containers_;
+
+    std::vector<Container>::iterator LowerBound(uint16_t high) {
+        return std::lower_bound(containers_.begin(), containers_.end(), high,
+                                [](const Container& c, uint16_t h) {return c.high < h;});
+    }
+
+    static size_t Ctz(uint64_t x) { // x != 0
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward64(&idx, x);
+        return idx;
+#else
+        return (size_t)__builtin_ctzll(x);
+#endif
+    }
+
+    static uint32_t Popcount(uint64_t x) {
+#if defined(_MSC_VER)
+        return (uint32_t)__popcnt64(x);
+#else
+        return (uint32_t)__builtin_popcountll(x);
+#endif
+    }
+
+    static void ToBitmap(Container& c) {
+        c.bits.assign(kWords, 0);
+        for (uint16_t low : c.array) c.bits[low >> 6] |= uint64_t(1) << (low & 63);
+        std::vector<uint16_t>().swap(c.array);
+    }
+
+    static void ToArray(Container& c) {
+        c.array.clear();
+        c.array.reserve(c.card);
+        for (size_t w = 0; w < kWords; ++w) {
+            uint64_t bits = c.bits[w];
+            while (bits) {
+                c.array.push_back(uint16_t(w * 64 + Ctz(bits)));
+                bits &= bits - 1;
+            }
+        }
+        std::vector<uint64_t>().swap(c.bits);
+    }
+
+    // после операции выбрать представление по числу значений
+    static void Normalize(Container& c) {
+        if (c.IsBitmap() && c.card <= kMaxArray) ToArray(c);
+        else if (!c.IsBitmap() && c.card > kMaxArray) ToBitmap(c);
+    }
+
+    static Container WithBits(uint16_t high, std::vector<uint64_t> bits) {
+        Container c;
+        c.high = high;
+        c.bits = std::move(bits);
+        for (uint64_t w : c.bits) c.card += Popcount(w);
+        if (c.card == 0) c.bits.clear();
+        Normalize(c);
+        return c;
+    }
+
+    static Container WithArray(uint16_t high, std::vector<uint16_t> array) {
+        Container c;
+        c.high = high;
+        c.card = uint32_t(array.size());
+        c.array = std::move(array);
+        Normalize(c);
+        return c;
+    }
+
+    static Container AndContainers(const Container& a, const Container& b) {
+        if (a.IsBitmap() && b.IsBitmap()) {
+            std::vector<uint64_t> bits(kWords);
+            for (size_t w = 0; w < kWords; ++w) bits[w] = a.bits[w] & b.bits[w];
+            return WithBits(a.high, std::move(bits));
+        }
+        std::vector<uint16_t> out;
+        if (!a.IsBitmap() && !b.IsBitmap()) {
+            std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                  std::back_inserter(out));
+        } else {
+            // массив фильтруется битсетом
+            const Container& arr = a.IsBitmap() ? b : a;
+            const Container& bm = a.IsBitmap() ? a : b;
+            for (uint16_t low : arr.array) {
+                if (bm.Contains(low)) out.push_back(low);
+            }
+        }
+        return WithArray(a.high, std::move(out));
+    }
+
+    static Container OrContainers(const Container& a, const Container& b) {
+        if (!a.IsBitmap() && !b.IsBitmap()) {
+            std::vector<uint16_t> out;
+            out.reserve(a.array.size() + b.array.size());
+            std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                           std::back_inserter(out));
+            return WithArray(a.high, std::move(out));
+        }
+        std::vector<uint64_t> bits = a.IsBitmap() ? a.bits : b.bits;
+        const Container& other = a.IsBitmap() ? b : a;
+        if (other.IsBitmap()) {
+            for (size_t w = 0; w < kWords; ++w) bits[w] |= other.bits[w];
+        } else {
+            for (uint16_t low : other.array) bits[low >> 6] |= uint64_t(1) << (low & 63);
+        }
+        return WithBits(a.high, std::move(bits));
+    }
+
+    static Container AndNotContainers(const Container& a, const Container& b) {
+        if (!a.IsBitmap()) {
+            std::vector<uint16_t> out;
+            for (uint16_t low : a.array) {
+                if (!b.Contains(low)) out.push_back(low);
+            }
+            return WithArray(a.high, std::move(out));
+        }
+        std::vector<uint64_t> bits = a.bits;
+        if (b.IsBitmap()) {
+            for (size_t w = 0; w < kWords; ++w) bits[w] &= ~b.bits[w];
+        } else {
+            for (uint16_t low : b.array) bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+        }
+        return WithBits(a.high, std::move(bits));
+    }
+};
+
+#endif // LAZYDB_ROARINGBITMAP_H
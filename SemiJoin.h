@@ -0,0 +1,125 @@
+#ifndef LAZYDB_SEMIJOIN_H
+#define LAZYDB_SEMIJOIN_H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+// Множество id родительской таблицы для пакетной проверки FK (semi-join "ключ есть в родителе?").
+// Если id лежат плотно (обычный случай для автоинкремента) - битсет по [min, max], проверка = один сдвиг;
+// иначе отсортированный массив и бинарный поиск
+class IdSet {
+public:
+    IdSet() {}
+
+    explicit IdSet(std::vector<int> ids) {
+        if (ids.empty()) return;
+        const auto mm = std::minmax_element(ids.begin(), ids.end());
+        min_ = *mm.first;
+        const uint64_t span = uint64_t(int64_t(*mm.second) - int64_t(min_)) + 1;
+        if (span <= uint64_t(ids.size()) * kMaxBitsPerId) {
+            span_ = span;
+            bits_.assign((span + 63) / 64, 0);
+            for (int id : ids) {
+                const uint64_t off = uint64_t(int64_t(id) - int64_t(min_));
+                bits_[off >> 6] |= uint64_t(1) << (off & 63);
+            }
+        } else {
+            std::sort(ids.begin(), ids.end());
+            sorted_ = std::move(ids);
+        }
+    }
+
+    bool Contains(int id) const {
+        if (!bits_.empty()) {
+            const uint64_t off = uint64_t(int64_t(id) - int64_t(min_)); // id < min_ даёт огромное off
+            return off < span_ && ((bits_[off >> 6] >> (off & 63)) & 1);
+        }
+        return std::binary_search(sorted_.begin(), sorted_.end(), id);
+    }
+
+    // Маска промахов для 64 ключей подряд: бит j = keys[j] нет в множестве.
+    // Цикл без ветвлений по данным, поэтому компилятор его векторизует
+    uint64_t MissMask(const int* keys, size_t n) const {
+        uint64_t miss = 0;
+        if (!bits_.empty()) {
+            for (size_t j = 0; j < n; ++j) {
+                const uint64_t off = uint64_t(int64_t(keys[j]) - int64_t(min_));
+                const uint64_t in = off < span_ ? (bits_[std::min(off, span_ - 1) >> 6] >> (off & 63)) & 1 : 0;
+                miss |= (in ^ 1) << j;
+            }
+        } else {
+            for (size_t j = 0; j < n; ++j) {
+                miss |= uint64_t(!Contains(keys[j])) << j;
+            }
+        }
+        return miss;
+    }
+
+private:
+    static constexpr uint64_t kMaxBitsPerId = 32; // битсет не больше 4 байт на id родителя
+
+    int min_ = 0;
+    uint64_t span_ = 0;
+    std::vector<uint64_t> bits_;
+    std::vector<int> sorted_;
+};
+
+inline size_t SemiJoinCtz(uint64_t x) { // x != 0
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return idx;
+#else
+    return (size_t)__builtin_ctzll(x);
+#endif
+}
+
+// Позиции keys, которых нет в parent (anti-semi-join), по возрастанию.
+// threads = 0 - по числу ядер; на маленьких входах потоки не запускаются
+inline std::vector<size_t> SemiJoinMisses(const std::vector<int>& keys, const IdSet& parent, size_t threads = 1) {
+    static const size_t kMinKeysPerThread = 1 << 16;
+
+    auto scan = [&](size_t from, size_t to, std::vector<size_t>& out) {
+        for (size_t base = from; base < to; base += 64) {
+            const size_t n = std::min<size_t>(64, to - base);
+            uint64_t miss = parent.MissMask(keys.data() + base, n);
+            while (miss) {
+                out.push_back(base + SemiJoinCtz(miss));
+                miss &= miss - 1;
+            }
+        }
+    };
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, std::max<size_t>(1, keys.size() / kMinKeysPerThread));
+
+    std::vector<size_t> out;
+    if (threads <= 1) {
+        scan(0, keys.size(), out);
+        return out;
+    }
+
+    // куски кратны 64, чтобы маски не пересекали границу потоков
+    const size_t chunk = ((keys.size() + threads - 1) / threads + 63) / 64 * 64;
+    std::vector<std::vector<size_t>> parts(threads);
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        const size_t from = std::min(keys.size(), t * chunk);
+        const size_t to = std::min(keys.size(), from + chunk);
+        pool.emplace_back([&, t, from, to] { scan(from, to, parts[t]); });
+    }
+    for (auto& th : pool) th.join();
+    for (auto& p : parts) out.insert(out.end(), p.begin(), p.end());
+    return out;
+}
+
+#endif // LAZYDB_SEMIJOIN_H
@@ -2,13 +2,24 @@
 #define LAZYDB_TABLE_H
 
 #include <fstream>
+#include <algorithm>
 #include <functional>
 #include <string>
 #include <vector>
 #include <type_traits>
 #include <sstream>
 #include <stdexcept>
-#include "core/HashTable.h"
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <thread>
+#include <exception>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "core/FlatHashTable.h"
+#include "core/MappedFile.h"
+#include "core/CsvReader.h"
 #include "db/DbErrors.h"
 
 template<typename T, typename IdT>
@@ -18,8 +29,12 @@ public:
 
     const std::string& GetTableName() const {return tableName_;} //получить имя табл
 
+    // threads > 1 (0 - по числу ядер): файл режется на куски по границам строк, куски разбираются
+    // параллельно в свои буферы, потом строки вставляются в порядке файла - слоты, дубли PK и номера
+    // строк файла (rowIndex в ошибках) те же, что при разборе в один поток
     template<typename IdGetter>
-    static Table LoadFromFile(const std::string& path,const std::string& tableName,IdGetter idGetter)
+    static Table LoadFromFile(const std::string& path,const std::string& tableName,IdGetter idGetter,
+                              size_t threads = 1)
     {
         Table t;
         t.tableName_ = tableName;
@@ -27,23 +42,32 @@ public:
        // idGetter передаётся извне
 
 
-        std::ifstream in(path); //Открываем файл
-        if (!in) {
+        // файл отображается в память и разбирается прямо по байтам: строки и поля - string_view,
+        // числа - from_chars; строка таблицы создаётся один раз и переносится в records_
+        MappedFile file;
+        if (!file.Open(path)) {
             return t;
         }
+        const std::string_view data = file.Data();
 
-        std::string line;
-        int rowIndex = 0;
+        static const size_t kMinBytesPerThread = 1 << 20; // на мелких файлах потоки дороже разбора
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, std::max<size_t>(1, data.size() / kMinBytesPerThread));
+        if (threads > 1) {
+            t.LoadChunks(SplitCsvLines(data, threads));
+            return t;
+        }
 
-        while (std::getline(in, line)) {
-            if (line.empty()) {
-                rowIndex++;
-                continue;
+        t.records_.reserve(std::count(data.begin(), data.end(), '\n') + 1);
+        int rowIndex = 0;
+        ForEachCsvRow(data, ';', [&](const CsvRow& row) {
+            if (!row.Line().empty()) {
+                t.InsertInternal(T::FromCsvRow(row), rowIndex, true); //разбирает CSV-строку и создаёт объект типа T
             }
-            T row = T::FromCSV(line); //разбирает CSV-строку и создаёт объект типа T
-            t.InsertInternal(row, rowIndex, true);
             rowIndex++; //Увеличиваем номер строки файла
-        }
+        });
         return t;
     }
 
@@ -60,10 +84,26 @@ public:
         return records_[slot];
     }
 
+    // обратное к GetRow: номер живой строки для слота (число живых слотов перед ним), O(log n)
+    size_t AliveIndexOfSlot(size_t slot) const {
+        size_t rank = 0;
+        for (size_t i = std::min(slot, records_.size()); i > 0; i -= LowBit(i)) {
+            rank += aliveRank_[i];
+        }
+        return rank;
+    }
+
     bool ContainsId(const IdT& id) const {
         return pkIndex_.ContainsKey(id);
     }
 
+    // слот живой строки с данным id или nullptr (для поддержки вторичных индексов)
+    const size_t* FindSlot(const IdT& id) const {
+        const size_t* slotPtr = pkIndex_.TryGet(id);
+        if (!slotPtr || !IsAliveSlot(*slotPtr)) return nullptr;
+        return slotPtr;
+    }
+
     void Insert(const T& row) {
         InsertInternal(row, -1, true);
     }
@@ -73,14 +113,15 @@ public:
         if (!slotPtr) return false;
 
         const size_t slot = *slotPtr;
-        if (slot >= alive_.size() || !alive_[slot]) {
+        if (!IsAliveSlot(slot)) {
             pkIndex_.Remove(id); //чистим индекс
             return false;
         }
         //помечаем как удалённую
         //уменьшаем число живых
         //слот кладём в freeList (можно повторно использовать при вставке)
-        alive_[slot] = 0;
+        SetAlive(slot, false);
+        RankAdd(slot, -1);
         aliveCount_--;
         freeList_.push_back(slot);
         pkIndex_.Remove(id);
@@ -92,7 +133,7 @@ public:
         if (!slotPtr) return false; // строки с таким id нет
 
         size_t slot = *slotPtr;
-        if (slot >= alive_.size() || !alive_[slot]) return false; // строка удалена
+        if (!IsAliveSlot(slot)) return false; // строка удалена
 
         // запрещаем менять первичный ключ
         if (idGetter_(newRow) != id) return false; // не даёт изменить первичный ключ при обновлении строки
@@ -104,7 +145,7 @@ public:
 public:
     // slot = индекс в records
     bool IsAliveSlot(size_t slot) const {
-        return slot < alive_.size() && alive_[slot];
+        return slot < records_.size() && ((aliveBits_[slot / 64] >> (slot % 64)) & 1u);
     }
 
     const T& GetRowBySlot(size_t slot) const {
@@ -118,25 +159,144 @@ public:
     std::vector<size_t> GetAliveSlots() const {
         std::vector<size_t> slots;
         slots.reserve(aliveCount_);
-        for (size_t i = 0; i < alive_.size(); ++i) {
-            if (alive_[i]) slots.push_back(i);
-        }
+        ForEachAlive([&](size_t slot, const T&) { slots.push_back(slot); });
         return slots;
     }
 
+    // обход живых строк без аллокаций: fn(slot, row) в порядке возрастания slot
+    // битовую карту читаем словами по 64 слота, пустые слова пропускаем целиком
+    template<typename F>
+    void ForEachAlive(F&& fn) const {
+        for (size_t w = 0; w < aliveBits_.size(); ++w) {
+            uint64_t bits = aliveBits_[w];
+            while (bits) {
+                const size_t slot = w * 64 + CountTrailingZeros(bits);
+                fn(slot, records_[slot]);
+                bits &= bits - 1; // снимаем младший бит
+            }
+        }
+    }
+
+    // то же только для слотов из [from, to) - так таблицу делят на куски между потоками
+    template<typename F>
+    void ForEachAliveInSlots(size_t from, size_t to, F&& fn) const {
+        to = std::min(to, records_.size());
+        if (from >= to) return;
+        const size_t lastWord = (to - 1) / 64;
+        for (size_t w = from / 64; w <= lastWord; ++w) {
+            uint64_t bits = aliveBits_[w];
+            if (w == from / 64) bits &= ~uint64_t(0) << (from % 64);
+            if (w == lastWord && to % 64 != 0) bits &= ~(~uint64_t(0) << (to % 64));
+            while (bits) {
+                const size_t slot = w * 64 + CountTrailingZeros(bits);
+                fn(slot, records_[slot]);
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    size_t GetSlotCount() const {return records_.size();} // слоты вместе с удалёнными: номера слотов < GetSlotCount()
+
+    // forward-итератор по живым строкам (range-for: for (const T& row : table))
+    class AliveIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        AliveIterator() = default;
+        AliveIterator(const Table* table, size_t slot) : table_(table), slot_(slot) {}
+
+        reference operator*() const { return table_->records_[slot_]; }
+        pointer operator->() const { return &table_->records_[slot_]; }
+        size_t Slot() const { return slot_; }
+
+        AliveIterator& operator++() {
+            slot_ = table_->NextAliveSlot(slot_ + 1);
+            return *this;
+        }
+        AliveIterator operator++(int) {
+            AliveIterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const AliveIterator& o) const { return slot_ == o.slot_; }
+        bool operator!=(const AliveIterator& o) const { return slot_ != o.slot_; }
+
+    private:
+        const Table* table_ = nullptr;
+        size_t slot_ = 0;
+    };
+
+    AliveIterator begin() const { return AliveIterator(this, NextAliveSlot(0)); }
+    AliveIterator end() const { return AliveIterator(this, records_.size()); }
+
 
 private:
     std::string tableName_ = "table";
     std::vector<T> records_;
-    std::vector<uint8_t> alive_;
+    std::vector<uint64_t> aliveBits_; // бит slot%64 слова slot/64 = строка живая
     std::vector<size_t> freeList_;
+    std::vector<size_t> aliveRank_; // дерево Фенвика по aliveBits_ для GetRow(aliveIndex)
     size_t aliveCount_ = 0; //живых строк.
 
-    HashTable<IdT, size_t> pkIndex_{1024};
+    // открытая адресация: PK-поиск без обхода цепочек; рост таблицы - инкрементальный (без пауз на Rehash)
+    FlatHashTable<IdT, size_t> pkIndex_{1024, 0.875, true};
     std::function<IdT(const T&)> idGetter_;
 
 
-    void InsertInternal(const T& row, int rowIndexForError, bool throwOnPkDuplicate) { // функция вставки строки в таблицу.
+    // строки одного куска файла: rows[i] стоит в строке lines[i] куска (номера от начала куска)
+    struct ParsedChunk {
+        std::vector<T> rows;
+        std::vector<int> lines;
+        int lineCount = 0; // строк в куске, включая пустые
+        std::exception_ptr error;
+    };
+
+    void LoadChunks(const std::vector<std::string_view>& chunks) {
+        std::vector<ParsedChunk> parsed(chunks.size());
+        std::vector<std::thread> pool;
+        for (size_t k = 0; k < chunks.size(); ++k) {
+            pool.emplace_back([&, k] {
+                ParsedChunk& p = parsed[k];
+                try {
+                    p.rows.reserve(std::count(chunks[k].begin(), chunks[k].end(), '\n') + 1);
+                    ForEachCsvRow(chunks[k], ';', [&](const CsvRow& row) {
+                        if (!row.Line().empty()) {
+                            p.rows.push_back(T::FromCsvRow(row));
+                            p.lines.push_back(p.lineCount);
+                        }
+                        p.lineCount++;
+                    });
+                } catch (...) {
+                    p.error = std::current_exception(); // кусок обрывается на первой плохой строке
+                }
+            });
+        }
+        for (auto& th : pool) th.join();
+
+        size_t total = 0;
+        for (const ParsedChunk& p : parsed) total += p.rows.size();
+        records_.reserve(total);
+
+        // слияние по порядку кусков; первая ошибка по порядку файла - та же, что бросил бы один поток.
+        // Буфер куска освобождается сразу после переноса, чтобы строки не жили в памяти дважды
+        int base = 0;
+        for (ParsedChunk& p : parsed) {
+            for (size_t i = 0; i < p.rows.size(); ++i) {
+                InsertInternal(std::move(p.rows[i]), base + p.lines[i], true);
+            }
+            if (p.error) std::rethrow_exception(p.error);
+            base += p.lineCount;
+            std::vector<T>().swap(p.rows);
+            std::vector<int>().swap(p.lines);
+        }
+    }
+
+    void InsertInternal(T row, int rowIndexForError, bool throwOnPkDuplicate) { // функция вставки строки в таблицу.
         IdT id = idGetter_(row); //Получаем первичный ключ строки
         if (pkIndex_.ContainsKey(id)) {
             return; // просто не вставляем дубликат
@@ -145,29 +305,87 @@ private:
         if (!freeList_.empty()) {
             slot = freeList_.back();
             freeList_.pop_back();
-            records_[slot] = row;
-            alive_[slot] = 1;
+            records_[slot] = std::move(row);
+            SetAlive(slot, true);
+            RankAdd(slot, +1);
         } else {
             slot = records_.size();
-            records_.push_back(row);
-            alive_.push_back(1);
+            records_.push_back(std::move(row));
+            if (slot % 64 == 0) aliveBits_.push_back(0);
+            SetAlive(slot, true);
+            RankAppend(1);
         }
         pkIndex_.Add(id, slot);
         aliveCount_++;
     }
 
+    void SetAlive(size_t slot, bool alive) {
+        const uint64_t mask = uint64_t(1) << (slot % 64);
+        if (alive) aliveBits_[slot / 64] |= mask;
+        else aliveBits_[slot / 64] &= ~mask;
+    }
+
+    static size_t CountTrailingZeros(uint64_t x) { // x != 0
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward64(&idx, x);
+        return idx;
+#else
+        return (size_t)__builtin_ctzll(x);
+#endif
+    }
+
+    // первый живой слот >= from, либо records_.size()
+    size_t NextAliveSlot(size_t from) const {
+        size_t w = from / 64;
+        if (w >= aliveBits_.size()) return records_.size();
+        uint64_t bits = aliveBits_[w] & (~uint64_t(0) << (from % 64));
+        while (!bits) {
+            if (++w == aliveBits_.size()) return records_.size();
+            bits = aliveBits_[w];
+        }
+        return w * 64 + CountTrailingZeros(bits);
+    }
+
+    // Дерево Фенвика над aliveBits_: aliveRank_[i] = число живых слотов в (i - lowbit(i), i] (1-based)
+    // rank и select за O(log n) вместо линейного прохода по битовой карте
+    static size_t LowBit(size_t i) { return i & (~i + 1); }
+
+    void RankAdd(size_t slot, long delta) {
+        for (size_t i = slot + 1; i < aliveRank_.size(); i += LowBit(i)) {
+            aliveRank_[i] += delta;
+        }
+    }
+
+    void RankAppend(size_t value) { // новый слот в конце records_
+        if (aliveRank_.empty()) aliveRank_.push_back(0); // фиктивный нулевой элемент
+        const size_t i = aliveRank_.size();
+        size_t sum = value;
+        // узел i покрывает отрезок (i - lowbit(i), i] - собираем его из уже готовых узлов
+        for (size_t j = i - 1; j > i - LowBit(i); j -= LowBit(j)) {
+            sum += aliveRank_[j];
+        }
+        aliveRank_.push_back(sum);
+    }
+
     size_t AliveIndexToSlot(size_t aliveIndex) const { //Какой реальный индекс в records_ соответствует живой строке
-        size_t count = 0;
-        for (size_t slot = 0; slot < alive_.size(); ++slot) {
-            if (alive_[slot]) {
-                if (count == aliveIndex) return slot;
-                count++;
+        if (aliveIndex >= aliveCount_) return 0;
+        const size_t n = aliveRank_.size() - 1;
+        size_t step = 1;
+        while (step * 2 <= n) step *= 2;
+
+        // спуск: ищем наибольший pos, у которого префикс живых <= aliveIndex
+        size_t pos = 0;
+        size_t rest = aliveIndex + 1;
+        for (; step > 0; step /= 2) {
+            if (pos + step <= n && aliveRank_[pos + step] < rest) {
+                pos += step;
+                rest -= aliveRank_[pos];
             }
         }
-        return 0;
+        return pos; // слот pos (0-based) = позиция pos+1 в дереве
     }
 
-
 };
 
 #endif // LAZYDB_TABLE_H
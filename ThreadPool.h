@@ -0,0 +1,166 @@
+#ifndef LAZYDB_THREADPOOL_H
+#define LAZYDB_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <chrono>
+#include <algorithm>
+
+
+// Пул с фиксированным числом потоков и общей очередью задач.
+// Задачи не должны ждать друг друга внутри пула (для зависимостей есть TaskGraph)
+class ThreadPool {
+public:
+    // threads = 0 - по числу ядер
+    explicit ThreadPool(size_t threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] {WorkerLoop();});
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t Size() const {return workers_.size();}
+
+    // задача не должна бросать: исключения ловит вызывающий (см. TaskGraph)
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+
+    void WorkerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] {return stop_ || !queue_.empty();});
+                if (queue_.empty()) return; // stop_ и очередь пуста
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+// Граф задач с зависимостями: задача уходит в пул, как только выполнены все её предки.
+// Если задача бросила, её потомки не запускаются. Номера задач = порядок Add, и Run бросает
+// исключение задачи с наименьшим номером - то же, что дал бы последовательный запуск в этом порядке
+class TaskGraph {
+public:
+    // deps - номера уже добавленных задач
+    size_t Add(std::string name, std::function<void()> fn, std::vector<size_t> deps = {}) {
+        const size_t id = tasks_.size();
+        Task t;
+        t.name = std::move(name);
+        t.fn = std::move(fn);
+        t.pending = deps.size();
+        tasks_.push_back(std::move(t));
+        for (size_t d : deps) {
+            tasks_[d].children.push_back(id);
+        }
+        return id;
+    }
+
+    void Run(ThreadPool& pool) {
+        remaining_ = tasks_.size();
+        // корни собираем до запуска: дальше pending уменьшают уже рабочие потоки
+        std::vector<size_t> roots;
+        for (size_t i = 0; i < tasks_.size(); ++i) {
+            if (tasks_[i].pending == 0) roots.push_back(i);
+        }
+        for (size_t i : roots) Schedule(pool, i);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] {return remaining_ == 0;});
+
+        for (const Task& t : tasks_) {
+            if (t.error) std::rethrow_exception(t.error);
+        }
+    }
+
+    // время выполнения каждой задачи (мс, wall clock); у пропущенных - 0
+    template<typename Fn>
+    void ForEachTiming(Fn&& fn) const {
+        for (const Task& t : tasks_) fn(t.name, t.ms);
+    }
+
+private:
+    struct Task {
+        std::string name;
+        std::function<void()> fn;
+        std::vector<size_t> children;
+        size_t pending = 0;
+        bool skipped = false; // упал кто-то из предков
+        std::exception_ptr error;
+        double ms = 0;
+    };
+
+    std::vector<Task> tasks_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+    size_t remaining_ = 0;
+
+    void Schedule(ThreadPool& pool, size_t id) {
+        pool.Submit([this, &pool, id] {
+            Task& t = tasks_[id];
+            if (!t.skipped) {
+                const auto start = std::chrono::steady_clock::now();
+                try {
+                    t.fn();
+                } catch (...) {
+                    t.error = std::current_exception();
+                }
+                t.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            Finish(pool, id);
+        });
+    }
+
+    void Finish(ThreadPool& pool, size_t id) {
+        std::vector<size_t> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const bool failed = tasks_[id].skipped || tasks_[id].error;
+            for (size_t c : tasks_[id].children) {
+                if (failed) tasks_[c].skipped = true;
+                if (--tasks_[c].pending == 0) ready.push_back(c);
+            }
+        }
+        // пропущенные тоже проходят через пул: так потомки узнают о пропуске тем же путём
+        for (size_t c : ready) Schedule(pool, c);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--remaining_ == 0) done_.notify_all();
+    }
+};
+
+#endif // LAZYDB_THREADPOOL_H
@@ -0,0 +1,476 @@
+// Замеры на сгенерированной таблице покупок:
+// - FindPurchaseIdsByDateRange на холодном кэше: покрывающий индекс (id в постингах)
+//   против прежней схемы "слоты из индекса + GetRowBySlot(s).GetId()";
+// - BuildIndexes целиком; сборка одного индекса и всех индексов purchases через IIndex::Build
+//   (std::function, как до шаблонных селекторов) против шаблонного Build со встроенным селектором
+//   (для замера на 5M строк: bench <папка> 5000000);
+// - правки запечатанного HashIndex: первая правка после Build и следующие, удаление всех строк
+//   горячего ключа подряд;
+// - Table::LoadFromFile на готовом файле покупок (bench load <purchases.csv> [повторов] [потоков]);
+// - разбор на строки и поля (CsvReader.h) в ГБ/с против getline + stringstream (bench scan <csv>...);
+// - поиск по int-ключу: BTree и BPlusTree (ключи в std::vector, lower_bound) против IntBPlusTree
+//   (плоские узлы, SIMD-поиск) при minDegree 4..64 (bench tree [число ключей] [поисков]);
+// - HashTable (цепочки) против FlatHashTable (Swiss table): вставка / поиск / удаление, нс на операцию,
+//   и задержка одной вставки с обычным и инкрементальным ростом: p50/p99/p999/max (bench hash [число ключей]);
+// - rank/select по живым строкам таблицы с удалёнными строками: GetRow(aliveIndex) и AliveIndexOfSlot
+//   по случайным номерам против прежнего линейного прохода (bench rank [число строк] [доля удалённых]);
+// - CollectConstraintErrors на сгенерированных покупках.
+// Запуск: bench <папка с csv> [число покупок] [повторов]
+// Покупки генерируются (ссылки на существующие отделы/поставщиков/товары) во временный csv,
+// остальные таблицы берутся из папки как есть.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <unordered_map>
+#include <tuple>
+#include "db/Database.h"
+#include "core/HashTable.h"
+#include "core/FlatHashTable.h"
+
+using Slot = size_t;
+
+// сюда складываются результаты замеров, чтобы оптимизатор не выбросил сами вычисления
+static volatile size_t benchSink = 0;
+
+static void Consume(size_t value) {
+    benchSink = benchSink + value;
+}
+
+// вытеснить кэши: пройти по буферу заметно больше последнего уровня кэша
+static void EvictCaches() {
+    static std::vector<char> junk(256u << 20, 1);
+    volatile char sink = 0;
+    for (size_t i = 0; i < junk.size(); i += 64) {
+        junk[i] += 1;
+        sink = sink + junk[i];
+    }
+}
+
+static std::string DateOfDay(int day) { // день 0..364 -> 2025-MM-DD (месяцы по 28 дней хватает для замера)
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "2025-%02d-%02d", 1 + day / 28 % 12, 1 + day % 28);
+    return buf;
+}
+
+static std::string WritePurchases(const Database& base, size_t count) {
+    std::vector<int> depts, suppliers, products;
+    base.Departments().ForEachAlive([&](Slot, const Department& d) {depts.push_back(d.GetId());});
+    base.Suppliers().ForEachAlive([&](Slot, const Supplier& s) {suppliers.push_back(s.GetId());});
+    base.Products().ForEachAlive([&](Slot, const Product& p) {products.push_back(p.GetId());});
+
+    const std::string path = "bench_purchases.csv";
+    std::ofstream out(path);
+    std::mt19937 rng(42);
+    for (size_t i = 1; i <= count; ++i) {
+        out << i << ';' << DateOfDay(int(rng() % 336)) << ';' << depts[rng() % depts.size()] << ';'
+            << suppliers[rng() % suppliers.size()] << ';' << products[rng() % products.size()] << ';'
+            << 1 + rng() % 100 << ";1.5\n";
+    }
+    return path;
+}
+
+template<typename F>
+static double MedianMs(size_t runs, bool cold, F&& query) {
+    std::vector<double> ms;
+    for (size_t r = 0; r < runs; ++r) {
+        if (cold) EvictCaches();
+        const auto start = std::chrono::steady_clock::now();
+        query();
+        ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    return ms[ms.size() / 2];
+}
+
+template<typename F>
+static double MedianColdMs(size_t runs, F&& query) {
+    return MedianMs(runs, true, query);
+}
+
+// индексы purchases из BuildIndexes (ссылки - слоты): до шаблонных селекторов - IIndex::Build
+// с std::function и копией ключа на строку, после - шаблонный Build со встроенным селектором
+static void BenchPurchaseIndexBuild(const Table<Purchase, int>& purchases, size_t runs) {
+    using DeptDateKey = std::tuple<int, std::string>;
+    using ProductSupplierKey = std::tuple<int, int>;
+    const std::vector<Slot> slots = purchases.GetAliveSlots();
+    auto row = [&](Slot s) -> const Purchase& {return purchases.GetRowBySlot(s);};
+
+    BTreeIndex<std::string, Slot, BPlusTree<std::string, Slot>> byDate(16);
+    BitmapIndex<int, Slot> bySupplier(64), byProduct(128), byDept(64);
+    BTreeIndex<DeptDateKey, Slot, BPlusTree<DeptDateKey, Slot>> byDeptDate(16);
+    HashIndex<ProductSupplierKey, Slot> byProductSupplier(2048);
+
+    const std::function<std::string(Slot)> date = [&](Slot s) {return row(s).GetDate();};
+    const std::function<int(Slot)> supplier = [&](Slot s) {return row(s).GetSupplierId();};
+    const std::function<int(Slot)> product = [&](Slot s) {return row(s).GetProductId();};
+    const std::function<int(Slot)> dept = [&](Slot s) {return row(s).GetDeptId();};
+    const std::function<DeptDateKey(Slot)> deptDate = [&](Slot s) {return DeptDateKey(row(s).GetDeptId(), row(s).GetDate());};
+    const std::function<ProductSupplierKey(Slot)> productSupplier = [&](Slot s) {
+        return ProductSupplierKey(row(s).GetProductId(), row(s).GetSupplierId());
+    };
+    const double before = MedianMs(runs, false, [&] {
+        static_cast<IIndex<std::string, Slot>&>(byDate).Build(slots, date);
+        static_cast<IIndex<int, Slot>&>(bySupplier).Build(slots, supplier);
+        static_cast<IIndex<int, Slot>&>(byProduct).Build(slots, product);
+        static_cast<IIndex<int, Slot>&>(byDept).Build(slots, dept);
+        static_cast<IIndex<DeptDateKey, Slot>&>(byDeptDate).Build(slots, deptDate);
+        static_cast<IIndex<ProductSupplierKey, Slot>&>(byProductSupplier).Build(slots, productSupplier);
+    });
+    const double after = MedianMs(runs, false, [&] {
+        byDate.Build(slots, [&](Slot s) -> const std::string& {return row(s).GetDate();});
+        bySupplier.Build(slots, [&](Slot s) {return row(s).GetSupplierId();});
+        byProduct.Build(slots, [&](Slot s) {return row(s).GetProductId();});
+        byDept.Build(slots, [&](Slot s) {return row(s).GetDeptId();});
+        byDeptDate.Build(slots, [&](Slot s) {return DeptDateKey(row(s).GetDeptId(), row(s).GetDate());});
+        byProductSupplier.Build(slots, [&](Slot s) {return ProductSupplierKey(row(s).GetProductId(), row(s).GetSupplierId());});
+    });
+    std::cout << "purchases indexes, " << slots.size() << " rows: std::function " << before
+              << " ms, template selectors " << after << " ms\n";
+}
+
+static void BenchIndexBuild(Database& db, size_t runs) {
+    const Table<Purchase, int>& purchases = db.Purchases();
+    const size_t buildRuns = std::max<size_t>(1, runs / 5);
+    std::cout << "BuildIndexes (1 thread): " << MedianMs(buildRuns, false, [&] {db.BuildIndexes(1);}) << " ms\n";
+
+    const std::vector<Slot> slots = purchases.GetAliveSlots();
+    HashIndex<std::string, Slot> byDate(2048);
+    IIndex<std::string, Slot>& viaInterface = byDate;
+    const std::function<std::string(Slot)> copyKey = [&](Slot s) {return purchases.GetRowBySlot(s).GetDate();};
+    const double viaFunction = MedianMs(buildRuns, false, [&] {viaInterface.Build(slots, copyKey);});
+    const double viaTemplate = MedianMs(buildRuns, false, [&] {
+        byDate.Build(slots, [&](Slot s) -> const std::string& {return purchases.GetRowBySlot(s).GetDate();});
+    });
+    std::cout << "HashIndex by date: std::function " << viaFunction << " ms, template selector "
+              << viaTemplate << " ms\n";
+    BenchPurchaseIndexBuild(purchases, buildRuns);
+}
+
+static int BenchLoad(const std::string& path, size_t runs, size_t threads) {
+    size_t rows = 0;
+    const double ms = MedianMs(runs, false, [&] {
+        rows = Table<Purchase, int>::LoadFromFile(path, "purchases", [](const Purchase& p) {return p.GetId();},
+                                                  threads).GetRowCount();
+    });
+    std::cout << path << ": " << rows << " rows, " << threads << " threads, LoadFromFile median " << ms << " ms ("
+              << rows / ms / 1000.0 << " M rows/s)\n";
+    return 0;
+}
+
+static int BenchScan(const std::vector<std::string>& paths) {
+    for (const std::string& path : paths) {
+        MappedFile file;
+        if (!file.Open(path)) {
+            std::cout << path << ": cannot open\n";
+            continue;
+        }
+        const std::string_view data = file.Data();
+        const std::string copy(data);
+        // маленькие файлы прогоняются по кругу, чтобы за замер прошло ~256 МБ
+        const size_t reps = std::max<size_t>(1, (size_t(256) << 20) / std::max<size_t>(1, data.size()));
+        size_t fields = 0, oldFields = 0;
+        const double ms = MedianMs(3, false, [&] {
+            for (size_t r = 0; r < reps; ++r) {
+                ForEachCsvRow(data, ';', [&](const CsvRow& row) {fields += row.Size();});
+            }
+        });
+        const double oldMs = MedianMs(3, false, [&] {
+            for (size_t r = 0; r < reps; ++r) {
+                std::istringstream in(copy);
+                std::string line, item;
+                while (std::getline(in, line)) {
+                    std::stringstream ss(line);
+                    while (std::getline(ss, item, ';')) ++oldFields;
+                }
+            }
+        });
+        const double bytes = double(data.size()) * reps;
+        std::cout << path << ": " << fields / 3 / reps << " fields, ForEachCsvRow " << bytes / ms / 1e6
+                  << " GB/s, getline + stringstream " << bytes / oldMs / 1e6 << " GB/s"
+                  << (fields == oldFields ? "" : " (field counts differ)") << "\n";
+    }
+    return 0;
+}
+
+static void BenchSealedEdits(const Table<Purchase, int>& purchases) {
+    using Clock = std::chrono::steady_clock;
+    auto usSince = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    };
+    const std::vector<Slot> slots = purchases.GetAliveSlots();
+    HashIndex<std::string, Slot> byDate(2048);
+    byDate.Build(slots, [&](Slot s) -> const std::string& {return purchases.GetRowBySlot(s).GetDate();});
+
+    // строка "переезжает" на другую дату, как при UpdateRow
+    auto move = [&](Slot s, const std::string& to) {
+        byDate.Remove(purchases.GetRowBySlot(s).GetDate(), s);
+        byDate.Insert(to, s);
+    };
+    auto start = Clock::now();
+    move(slots[0], "2030-01-01");
+    const double first = usSince(start);
+    std::vector<double> next;
+    for (size_t i = 1; i <= 1000 && i < slots.size(); ++i) {
+        start = Clock::now();
+        move(slots[i], "2030-01-01");
+        next.push_back(usSince(start));
+    }
+    std::sort(next.begin(), next.end());
+    std::cout << "sealed HashIndex edit: first " << first << " us, next median "
+              << next[next.size() / 2] << " us, max " << next.back() << " us\n";
+
+    // все строки одного отдела удаляются по одной, как DeleteRow
+    HashIndex<int, Slot> hot(64);
+    hot.Build(slots, [&](Slot s) {return purchases.GetRowBySlot(s).GetDeptId();});
+    const int key = purchases.GetRowBySlot(slots[0]).GetDeptId();
+    const std::vector<Slot> victims = hot.FindEquals(key);
+    start = Clock::now();
+    for (Slot s : victims) hot.Remove(key, s);
+    std::cout << "HashIndex remove all " << victims.size() << " refs of one key: " << usSince(start) / 1000 << " ms\n";
+}
+
+static std::vector<int> RandomKeys(size_t n, unsigned seed) {
+    std::vector<int> keys(n);
+    std::mt19937 rng(seed);
+    for (int& k : keys) k = int(rng() & 0x7fffffff);
+    return keys;
+}
+
+// паузы на рост таблицы: обычный Rehash переносит всё за одну вставку, инкрементальный - по частям
+template<typename Map>
+static void InsertLatency(const char* name, Map map, const std::vector<int>& keys) {
+    std::vector<double> ns;
+    ns.reserve(keys.size());
+    for (int k : keys) {
+        const auto start = std::chrono::steady_clock::now();
+        map.Set(k, k);
+        ns.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(ns.begin(), ns.end());
+    auto at = [&](double q) {return ns[std::min(ns.size() - 1, size_t(q * ns.size()))];};
+    std::cout << name << ": p50 " << at(0.5) << " ns, p99 " << at(0.99) << " ns, p999 " << at(0.999)
+              << " ns, max " << ns.back() / 1e6 << " ms\n";
+}
+
+// нс на операцию: n вставок, n успешных поисков в другом порядке, n удалений
+template<typename Map, typename Insert, typename Find, typename Erase>
+static void HashOps(const char* name, Map map, const std::vector<int>& keys, const std::vector<int>& order,
+                    Insert insert, Find find, Erase erase) {
+    using Clock = std::chrono::steady_clock;
+    auto nsPerOp = [&](Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / keys.size();
+    };
+    auto start = Clock::now();
+    for (int k : keys) insert(map, k);
+    const double inserted = nsPerOp(start);
+    long long sum = 0;
+    start = Clock::now();
+    for (int k : order) sum += find(map, k);
+    const double lookup = nsPerOp(start);
+    start = Clock::now();
+    for (int k : order) erase(map, k);
+    const double erased = nsPerOp(start);
+    Consume(size_t(sum));
+    std::cout << "  " << name << ": insert " << inserted << ", lookup " << lookup << ", erase " << erased << "\n";
+}
+
+static void BenchHashOps(size_t maxKeys) {
+    std::cout << "ns/op, random int keys (insert / lookup hit / erase)\n";
+    for (size_t n = 1000; n <= maxKeys; n *= 10) {
+        const std::vector<int> keys = RandomKeys(n, 11);
+        std::vector<int> order = keys;
+        std::shuffle(order.begin(), order.end(), std::mt19937(3));
+        std::cout << n << " keys\n";
+        auto set = [](auto& m, int k) {m.Set(k, k);};
+        auto get = [](auto& m, int k) {return *m.GetPtr(k);};
+        auto remove = [](auto& m, int k) {m.Remove(k);};
+        HashOps("HashTable", HashTable<int, int>(16), keys, order, set, get, remove);
+        HashOps("FlatHashTable", FlatHashTable<int, int>(16), keys, order, set, get, remove);
+        HashOps("std::unordered_map", std::unordered_map<int, int>(), keys, order,
+                [](auto& m, int k) {m[k] = k;}, [](auto& m, int k) {return m.find(k)->second;},
+                [](auto& m, int k) {m.erase(k);});
+    }
+}
+
+// нс на поиск FindPostings (без копии списка) по случайным существующим ключам
+template<typename Tree>
+static double TreeLookupNs(Tree& tree, const std::vector<int>& keys, const std::vector<int>& probes) {
+    for (size_t i = 0; i < keys.size(); ++i) tree.Insert(keys[i], Slot(i));
+    size_t found = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int k : probes) found += tree.FindPostings(k) != nullptr;
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (found != probes.size()) std::cout << "  (missed " << probes.size() - found << " keys)\n";
+    return ns / probes.size();
+}
+
+template<int MinDegree>
+static void BenchTreeDegree(const std::vector<int>& keys, const std::vector<int>& probes) {
+    BTree<int, Slot> btree(MinDegree);
+    BPlusTree<int, Slot> bplus(MinDegree);
+    IntBPlusTree<Slot, MinDegree> flat;
+    const double b = TreeLookupNs(btree, keys, probes);
+    const double p = TreeLookupNs(bplus, keys, probes);
+    const double f = TreeLookupNs(flat, keys, probes);
+    std::cout << "minDegree " << MinDegree << ": BTree " << b << " ns, BPlusTree " << p
+              << " ns, IntBPlusTree " << f << " ns\n";
+}
+
+static int BenchTree(size_t n, size_t lookups) {
+    const std::vector<int> keys = RandomKeys(n, 5);
+    std::vector<int> probes(lookups);
+    std::mt19937 rng(9);
+    for (int& k : probes) k = keys[rng() % keys.size()];
+    std::cout << n << " keys, " << lookups << " lookups, ns per FindPostings\n";
+    BenchTreeDegree<4>(keys, probes);
+    BenchTreeDegree<8>(keys, probes);
+    BenchTreeDegree<16>(keys, probes);
+    BenchTreeDegree<32>(keys, probes);
+    BenchTreeDegree<64>(keys, probes);
+    return 0;
+}
+
+static int BenchHash(size_t n) {
+    BenchHashOps(n);
+    const std::vector<int> keys = RandomKeys(n, 7);
+    std::cout << n << " random int keys, one Set each\n";
+    InsertLatency("HashTable", HashTable<int, int>(16), keys);
+    InsertLatency("HashTable incremental", HashTable<int, int>(16, 0.75, true), keys);
+    InsertLatency("FlatHashTable", FlatHashTable<int, int>(16), keys);
+    InsertLatency("FlatHashTable incremental", FlatHashTable<int, int>(16, 0.875, true), keys);
+    return 0;
+}
+
+// нс на операцию: fn(i) для каждого i из probes
+template<typename F>
+static double NsPerProbe(const std::vector<size_t>& probes, F&& fn) {
+    size_t sum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i : probes) sum += fn(i);
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    Consume(sum);
+    return ns / probes.size();
+}
+
+static int BenchRank(size_t rows, double deletedShare) {
+    const std::string path = "bench_rank.csv";
+    {
+        std::ofstream out(path);
+        for (size_t i = 1; i <= rows; ++i) out << i << ";2025-01-01;1;1;1;1;1.5\n";
+    }
+    Table<Purchase, int> table = Table<Purchase, int>::LoadFromFile(path, "purchases",
+                                                                    [](const Purchase& p) {return p.GetId();});
+    std::remove(path.c_str());
+    std::mt19937 rng(13);
+    for (size_t i = 1; i <= rows; ++i) {
+        if (rng() % 1000 < deletedShare * 1000) table.DeleteById(int(i));
+    }
+    const size_t alive = table.GetRowCount();
+    std::cout << rows << " rows, " << rows - alive << " deleted, " << alive << " alive\n";
+    if (alive == 0) return 0;
+
+    std::vector<size_t> indexes(1000000), slots(1000000);
+    for (size_t& i : indexes) i = rng() % alive;
+    for (size_t& s : slots) s = rng() % table.GetSlotCount();
+    std::cout << "GetRow(random aliveIndex): " << NsPerProbe(indexes, [&](size_t i) {
+        return size_t(table.GetRow(i).GetId());
+    }) << " ns\n";
+    std::cout << "AliveIndexOfSlot(random slot): " << NsPerProbe(slots, [&](size_t s) {
+        return table.AliveIndexOfSlot(s);
+    }) << " ns\n";
+
+    // прежний GetRow: проход по слотам до aliveIndex-й живой строки
+    const std::vector<size_t> few(indexes.begin(), indexes.begin() + 200);
+    std::cout << "linear scan to aliveIndex: " << NsPerProbe(few, [&](size_t target) {
+        size_t seen = 0, id = 0;
+        for (Slot s = 0; s < table.GetSlotCount(); ++s) {
+            if (!table.IsAliveSlot(s)) continue;
+            if (seen++ == target) {
+                id = size_t(table.GetRowBySlot(s).GetId());
+                break;
+            }
+        }
+        return id;
+    }) / 1000.0 << " us\n";
+
+    std::cout << "all rows via GetRow(i): " << MedianMs(3, false, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < alive; ++i) sum += size_t(table.GetRow(i).GetId());
+        Consume(sum);
+    }) << " ms, via ForEachAlive: " << MedianMs(3, false, [&] {
+        size_t sum = 0;
+        table.ForEachAlive([&](Slot, const Purchase& p) {sum += size_t(p.GetId());});
+        Consume(sum);
+    }) << " ms\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "rank") {
+        return BenchRank(argc > 2 ? std::stoul(argv[2]) : 1000000, argc > 3 ? std::stod(argv[3]) : 0.5);
+    }
+    if (argc > 1 && std::string(argv[1]) == "tree") {
+        return BenchTree(argc > 2 ? std::stoul(argv[2]) : 1000000, argc > 3 ? std::stoul(argv[3]) : 2000000);
+    }
+    if (argc > 1 && std::string(argv[1]) == "hash") {
+        return BenchHash(argc > 2 ? std::stoul(argv[2]) : 5000000);
+    }
+    if (argc > 2 && std::string(argv[1]) == "scan") {
+        return BenchScan(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 2 && std::string(argv[1]) == "load") {
+        return BenchLoad(argv[2], argc > 3 ? std::stoul(argv[3]) : 3, argc > 4 ? std::stoul(argv[4]) : 1);
+    }
+    const std::string dir = argc > 1 ? std::string(argv[1]) + "/" : "data/";
+    const size_t count = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    const size_t runs = argc > 3 ? std::stoul(argv[3]) : 15;
+
+    Database base = Database::LoadFromFiles(dir + "addresses.csv", dir + "departments.csv", dir + "employees.csv",
+                                            dir + "suppliers.csv", dir + "products.csv", dir + "purchases.csv");
+    const std::string purchasesPath = WritePurchases(base, count);
+    Database db = Database::LoadFromFiles(dir + "addresses.csv", dir + "departments.csv", dir + "employees.csv",
+                                          dir + "suppliers.csv", dir + "products.csv", purchasesPath);
+    std::remove(purchasesPath.c_str());
+
+    // прежняя схема: в постингах только слоты
+    const Table<Purchase, int>& purchases = db.Purchases();
+    BTreeIndex<std::string, Slot, BPlusTree<std::string, Slot>> bySlot(16);
+    std::vector<std::pair<std::string, Slot>> pairs;
+    purchases.ForEachAlive([&](Slot s, const Purchase& p) {pairs.emplace_back(p.GetDate(), s);});
+    bySlot.BulkLoad(std::move(pairs), 0.9);
+
+    std::cout << "purchases: " << purchases.GetRowCount() << ", runs: " << runs << "\n";
+    BenchIndexBuild(db, runs);
+    BenchSealedEdits(purchases);
+    size_t errors = 0;
+    const double validateMs = MedianMs(std::max<size_t>(1, runs / 5), false, [&] {
+        errors = db.CollectConstraintErrors().size();
+    });
+    std::cout << "CollectConstraintErrors: " << validateMs << " ms, " << errors << " errors\n";
+
+    const std::pair<std::string, std::string> ranges[] = {
+        {"2025-03-01", "2025-03-07"}, {"2025-03-01", "2025-03-28"}, {"2025-01-01", "2025-06-28"}};
+    for (const auto& range : ranges) {
+        size_t hits = 0;
+        const double covering = MedianColdMs(runs, [&] {
+            hits = db.FindPurchaseIdsByDateRange(range.first, range.second).size();
+        });
+        const double slots = MedianColdMs(runs, [&] {
+            std::vector<int> ids;
+            for (Slot s : bySlot.FindRange(range.first, range.second)) {
+                ids.push_back(purchases.GetRowBySlot(s).GetId());
+            }
+            hits = ids.size();
+        });
+        std::cout << range.first << ".." << range.second << ": " << hits << " ids, covering "
+                  << covering << " ms, slots + GetRowBySlot " << slots << " ms\n";
+    }
+    return 0;
+}
@@ -6,21 +6,27 @@
 #include <wx/filename.h>
 #include <wx/dirdlg.h>
 #include <fstream>
-#include <sstream>
+#include <string_view>
 #include <vector>
 #include <string>
 #include <algorithm>
 #include <unordered_set>
 #include "db/Database.h"
 #include "db/DbErrors.h"
+#include "core/MappedFile.h"
+#include "core/CsvReader.h"
 
 
-//разбить строку CSV по ;
-static std::vector<std::string> Split(const std::string& s, char delim) {
+//разбить строку CSV по ; (общий SIMD-поиск из CsvReader.h; пустое последнее поле, как у getline, не считается)
+static std::vector<std::string> Split(std::string_view s, char delim) {
     std::vector<std::string> parts;
-    std::stringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) parts.push_back(item);
+    size_t pos = 0;
+    CsvForEachMatch(s, delim, [&](size_t end) {
+        parts.emplace_back(s.substr(pos, end - pos));
+        pos = end + 1;
+        return true;
+    });
+    if (pos < s.size()) parts.emplace_back(s.substr(pos));
     return parts;
 }
 //собрать строку обратно из ячеек, тоже через ;
@@ -32,6 +38,11 @@ static std::string JoinRow(const std::vector<std::string>& cells, char delim=';'
     }
     return out;
 }
+//текст wxString как string_view без копии в std::string: байты те же, что у ToStdString (так ячейки
+//попадают в таблицы). Временный буфер живёт до конца выражения - на один вызов Find* хватает
+static std::string_view ViewOf(const wxScopedCharBuffer& buf) {
+    return std::string_view(buf.data(), buf.length());
+}
 
 struct TableSpec {
     wxString title;
@@ -121,13 +132,12 @@ public:
     }
 
     void LoadFromFile(const wxString& path) {
-        std::ifstream in(path.ToStdString());
-        if (!in) throw std::runtime_error("Cannot open file: " + path.ToStdString());
+        MappedFile file;
+        if (!file.Open(path.ToStdString())) throw std::runtime_error("Cannot open file: " + path.ToStdString());
 
         std::vector<std::vector<std::string>> rows;
-        std::string line;
-        while (std::getline(in, line)) {
-            if (line.empty()) continue;
+        ForEachCsvLine(file.Data(), [&](std::string_view line) {
+            if (line.empty()) return;
             auto parts = Split(line, ';');
             if ((int)parts.size() != (int)spec_.columns.size()) { //проверка на число колонок
                 throw std::runtime_error(
@@ -137,7 +147,7 @@ public:
                 );
             }
             rows.push_back(std::move(parts));
-        }
+        });
 
         const int oldRows = grid_->GetNumberRows();
         if (oldRows > 0) grid_->DeleteRows(0, oldRows);
@@ -956,7 +966,7 @@ void HighlightRowsByIds(int tab, const std::vector<int>& ids) { //подсвеч
                 if (field == "city") {
                     wxString v = getText(searchV1_);
                     if (v.IsEmpty()) {wxMessageBox("Enter city", "Search", wxOK | wxICON_WARNING, this); return;}
-                    ids = db.FindAddressIdsByCity(v.ToStdString());
+                    ids = db.FindAddressIdsByCity(ViewOf(v.mb_str()));
                 } else if (field == "id_range") {
                     long a=0,b=0;
                     if (!getText(searchV1_).ToLong(&a) || !getText(searchV2_).ToLong(&b)) {
@@ -969,7 +979,7 @@ void HighlightRowsByIds(int tab, const std::vector<int>& ids) { //подсвеч
                 if (field == "name") {
                     wxString v = getText(searchV1_);
                     if (v.IsEmpty()) { wxMessageBox("Enter department name", "Search", wxOK | wxICON_WARNING, this); return; }
-                    ids = db.FindDepartmentIdsByName(v.ToStdString());
+                    ids = db.FindDepartmentIdsByName(ViewOf(v.mb_str()));
                 } else if (field == "address_id") {
                     long v=0;
                     if (!getText(searchV1_).ToLong(&v)) { wxMessageBox("Enter address_id (integer)", "Search", wxOK | wxICON_WARNING, this); return; }
@@ -979,7 +989,7 @@ void HighlightRowsByIds(int tab, const std::vector<int>& ids) { //подсвеч
                 if (field == "full_name") {
                     wxString v = getText(searchV1_);
                     if (v.IsEmpty()) { wxMessageBox("Enter full name (as stored)", "Search", wxOK | wxICON_WARNING, this); return; }
-                    ids = db.FindEmployeeIdsByFullName(v.ToStdString());
+                    ids = db.FindEmployeeIdsByFullName(ViewOf(v.mb_str()));
                 } else if (field == "birth_year") {
                     long a=0,b=0;
                     if (!getText(searchV1_).ToLong(&a) || !getText(searchV2_).ToLong(&b)) {
@@ -996,17 +1006,17 @@ void HighlightRowsByIds(int tab, const std::vector<int>& ids) { //подсвеч
                 if (field == "name") {
                     wxString v = getText(searchV1_);
                     if (v.IsEmpty()) { wxMessageBox("Enter supplier name", "Search", wxOK | wxICON_WARNING, this); return; }
-                    ids = db.FindSupplierIdsByName(v.ToStdString());
+                    ids = db.FindSupplierIdsByName(ViewOf(v.mb_str()));
                 } else if (field == "city") {
                     wxString v = getText(searchV1_);
                     if (v.IsEmpty()) { wxMessageBox("Enter city", "Search", wxOK | wxICON_WARNING, this); return; }
-                    ids = db.FindSupplierIdsByCity(v.ToStdString());
+                    ids = db.FindSupplierIdsByCity(ViewOf(v.mb_str()));
                 }
             } else if (tab == 4) { // Products
                 if (field == "name") {
                     wxString v = getText(searchV1_);
                     if (v.IsEmpty()) { wxMessageBox("Enter product name", "Search", wxOK | wxICON_WARNING, this); return; }
-                    ids = db.FindProductIdsByName(v.ToStdString());
+                    ids = db.FindProductIdsByName(ViewOf(v.mb_str()));
                 } else if (field == "default_supplier_id") {
                     long v=0;
                     if (!getText(searchV1_).ToLong(&v)) { wxMessageBox("Enter default_supplier_id (integer)", "Search", wxOK | wxICON_WARNING, this); return; }
@@ -1,16 +1,7 @@
 #include "model/Address.h"
 
-#include <sstream>
-#include <vector>
 #include <stdexcept>
-
-static std::vector<std::string> split(const std::string& s, char delim) {
-    std::vector<std::string> parts;
-    std::stringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) parts.push_back(item);
-    return parts;
-}
+#include "core/CsvReader.h"
 
 Address::Address(int id, std::string city, std::string street, std::string building, std::string type)
     : id_(id),
@@ -20,18 +11,20 @@ Address::Address(int id, std::string city, std::string street, std::string build
       type_(std::move(type)) {}
 
 Address Address::FromCSV(const std::string& line) {
-    auto p = split(line, ';');
-    if (p.size() < 4) throw std::runtime_error("Bad Address CSV line: " + line);
+    return FromCsvRow(CsvRow(line, ';'));
+}
 
+Address Address::FromCsvRow(const CsvRow& row) {
+    if (row.Size() < 4) throw std::runtime_error("Bad Address CSV line: " + std::string(row.Line()));
     // формат ожидаем: id;city;street;building;type
-    std::string type = (p.size() >= 5 ? p[4] : "Unknown");
+    std::string type = (row.Size() >= 5 ? row.Str(4) : "Unknown");
     if (type.empty()) type = "Unknown";
 
     return Address(
-        std::stoi(p[0]),
-        p[1],
-        p[2],
-        p[3],
-        type
+        row.Int(0),
+        row.Str(1),
+        row.Str(2),
+        row.Str(3),
+        std::move(type)
     );
 }
@@ -3,6 +3,8 @@
 
 #include <string>
 
+class CsvRow;
+
 class Address {
 public:
     Address() = default;
@@ -17,6 +19,7 @@ public:
     //const до  нельзя поменять сроку, которую выдаст функция
     //const после запрещает менять объект (this) внутри метода и позволяет вызывать этот метод у const-объектов
     static Address FromCSV(const std::string& line);
+    static Address FromCsvRow(const CsvRow& row); // поля уже разобраны (загрузка таблицы)
 
 private:
     int id_ = 0;
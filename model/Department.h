@@ -3,6 +3,8 @@
 
 #include <string>
 
+class CsvRow;
+
 class Department {
 public:
     Department() = default;
@@ -13,6 +15,7 @@ public:
     int GetAddressId() const { return addressId_; }
 
     static Department FromCSV(const std::string& line);
+    static Department FromCsvRow(const CsvRow& row); // поля уже разобраны (загрузка таблицы)
 
 private:
     int id_ = 0;
@@ -1,16 +1,7 @@
 #include "model/Employee.h"
 
-#include <sstream>
-#include <vector>
 #include <stdexcept>
-
-static std::vector<std::string> split(const std::string& s, char delim) {
-    std::vector<std::string> parts;
-    std::stringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) parts.push_back(item);
-    return parts;
-}
+#include "core/CsvReader.h"
 
 Employee::Employee(int id, std::string last, std::string first, std::string middle, int birthYear, int deptId)
     : id_(id),
@@ -25,7 +16,10 @@ std::string Employee::GetFullName() const {
 }
 
 Employee Employee::FromCSV(const std::string& line) {
-    auto p = split(line, ';');
-    if (p.size() < 6) throw std::runtime_error("Bad Employee CSV line: " + line);
-    return Employee(std::stoi(p[0]), p[1], p[2], p[3], std::stoi(p[4]), std::stoi(p[5]));
+    return FromCsvRow(CsvRow(line, ';'));
+}
+
+Employee Employee::FromCsvRow(const CsvRow& row) {
+    if (row.Size() < 6) throw std::runtime_error("Bad Employee CSV line: " + std::string(row.Line()));
+    return Employee(row.Int(0), row.Str(1), row.Str(2), row.Str(3), row.Int(4), row.Int(5));
 }
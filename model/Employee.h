@@ -3,6 +3,8 @@
 
 #include <string>
 
+class CsvRow;
+
 class Employee {
 public:
     Employee() = default;
@@ -17,6 +19,7 @@ public:
 
     std::string GetFullName() const;
     static Employee FromCSV(const std::string& line);
+    static Employee FromCsvRow(const CsvRow& row); // поля уже разобраны (загрузка таблицы)
 
 private:
     int id_ = 0;
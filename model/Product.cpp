@@ -1,16 +1,7 @@
 #include "model/Product.h"
 
-#include <sstream>
-#include <vector>
 #include <stdexcept>
-
-static std::vector<std::string> split(const std::string& s, char delim) {
-    std::vector<std::string> parts;
-    std::stringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) parts.push_back(item);
-    return parts;
-}
+#include "core/CsvReader.h"
 
 Product::Product(int id, std::string name, std::string category, std::string unit, int defaultSupplierId)
     : id_(id),
@@ -20,7 +11,10 @@ Product::Product(int id, std::string name, std::string category, std::string uni
       defaultSupplierId_(defaultSupplierId) {}
 
 Product Product::FromCSV(const std::string& line) {
-    auto p = split(line, ';');
-    if (p.size() < 5) throw std::runtime_error("Bad Product CSV line: " + line);
-    return Product(std::stoi(p[0]), p[1], p[2], p[3], std::stoi(p[4]));
+    return FromCsvRow(CsvRow(line, ';'));
+}
+
+Product Product::FromCsvRow(const CsvRow& row) {
+    if (row.Size() < 5) throw std::runtime_error("Bad Product CSV line: " + std::string(row.Line()));
+    return Product(row.Int(0), row.Str(1), row.Str(2), row.Str(3), row.Int(4));
 }
@@ -3,6 +3,8 @@
 
 #include <string>
 
+class CsvRow;
+
 class Product {
 public:
     Product() = default;
@@ -15,6 +17,7 @@ public:
     int GetDefaultSupplierId() const { return defaultSupplierId_; }
 
     static Product FromCSV(const std::string& line);
+    static Product FromCsvRow(const CsvRow& row); // поля уже разобраны (загрузка таблицы)
 
 private:
     int id_ = 0;
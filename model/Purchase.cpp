@@ -1,16 +1,7 @@
 #include "model/Purchase.h"
 
-#include <sstream>
-#include <vector>
 #include <stdexcept>
-
-static std::vector<std::string> split(const std::string& s, char delim) {
-    std::vector<std::string> parts;
-    std::stringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) parts.push_back(item);
-    return parts;
-}
+#include "core/CsvReader.h"
 
 Purchase::Purchase(int id, std::string date, int deptId, int supplierId, int productId, int qty, double unitPrice)
     : id_(id),
@@ -22,16 +13,18 @@ Purchase::Purchase(int id, std::string date, int deptId, int supplierId, int pro
       unitPrice_(unitPrice) {}
 
 Purchase Purchase::FromCSV(const std::string& line) {
-    auto p = split(line, ';');
-    if (p.size() < 7) throw std::runtime_error("Bad Purchase CSV line: " + line);
+    return FromCsvRow(CsvRow(line, ';'));
+}
 
+Purchase Purchase::FromCsvRow(const CsvRow& row) {
+    if (row.Size() < 7) throw std::runtime_error("Bad Purchase CSV line: " + std::string(row.Line()));
     return Purchase(
-        std::stoi(p[0]),
-        p[1],
-        std::stoi(p[2]),
-        std::stoi(p[3]),
-        std::stoi(p[4]),
-        std::stoi(p[5]),
-        std::stod(p[6])
+        row.Int(0),
+        row.Str(1),
+        row.Int(2),
+        row.Int(3),
+        row.Int(4),
+        row.Int(5),
+        row.Double(6)
     );
 }
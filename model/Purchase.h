@@ -3,6 +3,8 @@
 
 #include <string>
 
+class CsvRow;
+
 class Purchase {
 public:
     Purchase() = default;
@@ -17,6 +19,7 @@ public:
     double GetUnitPrice() const { return unitPrice_; }
 
     static Purchase FromCSV(const std::string& line);
+    static Purchase FromCsvRow(const CsvRow& row); // поля уже разобраны (загрузка таблицы)
 
 private:
     int id_ = 0;
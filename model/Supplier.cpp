@@ -1,16 +1,7 @@
 #include "model/Supplier.h"
 
-#include <sstream>
-#include <vector>
 #include <stdexcept>
-
-static std::vector<std::string> split(const std::string& s, char delim) {
-    std::vector<std::string> parts;
-    std::stringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) parts.push_back(item);
-    return parts;
-}
+#include "core/CsvReader.h"
 
 Supplier::Supplier(int id, std::string name, std::string city, std::string phone, std::string email)
     : id_(id),
@@ -20,7 +11,10 @@ Supplier::Supplier(int id, std::string name, std::string city, std::string phone
       email_(std::move(email)) {}
 
 Supplier Supplier::FromCSV(const std::string& line) {
-    auto p = split(line, ';');
-    if (p.size() < 5) throw std::runtime_error("Bad Supplier CSV line: " + line);
-    return Supplier(std::stoi(p[0]), p[1], p[2], p[3], p[4]);
+    return FromCsvRow(CsvRow(line, ';'));
+}
+
+Supplier Supplier::FromCsvRow(const CsvRow& row) {
+    if (row.Size() < 5) throw std::runtime_error("Bad Supplier CSV line: " + std::string(row.Line()));
+    return Supplier(row.Int(0), row.Str(1), row.Str(2), row.Str(3), row.Str(4));
 }
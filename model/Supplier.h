@@ -3,6 +3,8 @@
 
 #include <string>
 
+class CsvRow;
+
 class Supplier {
 public:
     Supplier() = default;
@@ -15,6 +17,7 @@ public:
     const std::string& GetEmail() const { return email_; }
 
     static Supplier FromCSV(const std::string& line);
+    static Supplier FromCsvRow(const CsvRow& row); // поля уже разобраны (загрузка таблицы)
 
 private:
     int id_ = 0;